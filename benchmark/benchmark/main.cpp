@@ -240,8 +240,64 @@ private:
   std::array<int, size> values;
 };
 
-ref<array_data> ConstructLinearSequenceArray(std::size_t exponent,
-                                             ref<array_data> x)
+// `array_data` with a version stamp, so the engine detects its changes
+// without comparing the contents
+class versioned_array_data
+{
+public:
+  using version_type = std::size_t;
+
+public:
+  versioned_array_data(int x = 0)
+  : data_(x)
+  , version_(next_version_())
+  {
+  }
+
+  version_type version() const
+  {
+    return version_;
+  }
+
+  bool operator==(const versioned_array_data& other) const
+  {
+    return data_ == other.data_;
+  }
+
+  bool operator!=(const versioned_array_data& other) const
+  {
+    return !(*this == other);
+  }
+
+  versioned_array_data& operator++()
+  {
+    ++data_;
+    version_ = next_version_();
+
+    return *this;
+  }
+
+  friend std::ostream& operator<<(std::ostream& out,
+                                  const versioned_array_data& data)
+  {
+    return out << data.data_;
+  }
+
+private:
+  static std::size_t next_version_()
+  {
+    static std::size_t version = 0;
+
+    return ++version;
+  }
+
+private:
+  array_data data_;
+  std::size_t version_;
+};
+
+template <typename T>
+ref<T> ConstructLinearSequenceArray(std::size_t exponent, ref<T> x)
 {
   if (exponent == 0)
     return x;
@@ -251,9 +307,10 @@ ref<array_data> ConstructLinearSequenceArray(std::size_t exponent,
   return ConstructLinearSequenceArray(exponent - 1, y++);
 }
 
-std::pair<ref<array_data>, std::size_t>
+template <typename T>
+std::pair<ref<T>, std::size_t>
 ConstructLinearSequenceArrayAndPrintDescription(std::size_t exponent,
-                                                ref<array_data> x)
+                                                ref<T> x)
 {
   const auto prev = std::cout.fill('-');
 
@@ -263,7 +320,7 @@ ConstructLinearSequenceArrayAndPrintDescription(std::size_t exponent,
   std::cout << "      `-----" << std::right << std::setw(10)
             << (1 << exponent) - 1 << " times------'" << std::endl;
   std::cout << std::endl;
-  std::cout << "sizeof(x) = " << sizeof(array_data) << " bytes" << std::endl;
+  std::cout << "sizeof(x) = " << sizeof(T) << " bytes" << std::endl;
   std::cout << std::endl;
 
   std::cout.fill(prev);
@@ -389,9 +446,21 @@ int main(int argc, char** argv)
   Benchmark<int>(ConstructBinaryAndPrintDescription,
                  engine_options::fully_optimized);
 
+  std::cout << Title2("Binary nodes update (parallel)") << std::endl;
+
+  Benchmark<int>(ConstructBinaryAndPrintDescription,
+                 engine_options::parallel_update);
+
   std::cout << Title2("Linear sequence update (array data)") << std::endl;
 
-  Benchmark<array_data>(ConstructLinearSequenceArrayAndPrintDescription);
+  Benchmark<array_data>(
+    ConstructLinearSequenceArrayAndPrintDescription<array_data>);
+
+  std::cout << Title2("Linear sequence update (versioned array data)")
+            << std::endl;
+
+  Benchmark<versioned_array_data>(
+    ConstructLinearSequenceArrayAndPrintDescription<versioned_array_data>);
 
   return 0;
 }
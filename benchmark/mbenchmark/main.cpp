@@ -71,6 +71,24 @@ static void Construct_Unary_Incr_Int(benchmark::State& state)
 
 BENCHMARK(Construct_Unary_Incr_Int);
 
+static void Construct_Unary_Incr_Int_Pooled(benchmark::State& state)
+{
+  Engine engine{engine_options::fully_optimized |
+                engine_options::pooled_allocation};
+
+  const auto x = Var(1);
+
+  std::vector<ref<int>> tmp;
+  tmp.reserve(state.max_iterations);
+
+  for (auto _ : state)
+  {
+    tmp.push_back(Incr(x));
+  }
+}
+
+BENCHMARK(Construct_Unary_Incr_Int_Pooled);
+
 static void Construct_Binary_Add_Int(benchmark::State& state)
 {
   Engine engine;
@@ -133,6 +151,130 @@ static void Update_Unary_Incr_Int(benchmark::State& state)
 
 BENCHMARK(Update_Unary_Incr_Int);
 
+static void Update_Unary_Incr_Int_Dense(benchmark::State& state)
+{
+  Engine engine{engine_options::fully_optimized |
+                engine_options::dense_scheduling};
+
+  auto x = Var(1);
+
+  std::vector<ref<int>> tmp(1, x);
+
+  for (benchmark::IterationCount i = 0; i < state.max_iterations; ++i)
+  {
+    const auto a = tmp.front();
+    tmp.pop_back();
+    tmp.push_back(Incr(a));
+  }
+
+  const auto y = Main(tmp.front());
+
+  while (state.KeepRunningBatch(state.max_iterations))
+  {
+    x = 2;
+  }
+}
+
+BENCHMARK(Update_Unary_Incr_Int_Dense);
+
+static void Update_Chain_Incr_Int(benchmark::State& state)
+{
+  Engine engine;
+
+  auto x = Var(1);
+
+  std::vector<ref<int>> tmp(1, x);
+
+  for (std::int64_t i = 0; i < state.range(0); ++i)
+  {
+    const auto a = tmp.front();
+    tmp.pop_back();
+    tmp.push_back(Incr(a));
+  }
+
+  const auto y = Main(tmp.front());
+
+  int v = 0;
+  for (auto _ : state)
+  {
+    x = ++v;
+  }
+}
+
+BENCHMARK(Update_Chain_Incr_Int)->Arg(16384);
+
+static void Update_Chain_Incr_Int_Fused(benchmark::State& state)
+{
+  Engine engine{engine_options::fully_optimized |
+                engine_options::chain_fusion};
+
+  auto x = Var(1);
+
+  std::vector<ref<int>> tmp(1, x);
+
+  for (std::int64_t i = 0; i < state.range(0); ++i)
+  {
+    const auto a = tmp.front();
+    tmp.pop_back();
+    tmp.push_back(Incr(a));
+  }
+
+  const auto y = Main(tmp.front());
+
+  int v = 0;
+  for (auto _ : state)
+  {
+    x = ++v;
+  }
+}
+
+BENCHMARK(Update_Chain_Incr_Int_Fused)->Arg(16384);
+
+static void Update_Fanout_Incr_Int(benchmark::State& state)
+{
+  Engine engine;
+
+  auto x = Var(1);
+
+  std::vector<val<int>> tmp;
+
+  for (std::int64_t i = 0; i < state.range(0); ++i)
+  {
+    tmp.push_back(Main(Incr(x)));
+  }
+
+  int v = 0;
+  for (auto _ : state)
+  {
+    x = ++v;
+  }
+}
+
+BENCHMARK(Update_Fanout_Incr_Int)->Arg(64)->Arg(4096);
+
+static void Update_Fanout_Incr_Int_Dense(benchmark::State& state)
+{
+  Engine engine{engine_options::fully_optimized |
+                engine_options::dense_scheduling};
+
+  auto x = Var(1);
+
+  std::vector<val<int>> tmp;
+
+  for (std::int64_t i = 0; i < state.range(0); ++i)
+  {
+    tmp.push_back(Main(Incr(x)));
+  }
+
+  int v = 0;
+  for (auto _ : state)
+  {
+    x = ++v;
+  }
+}
+
+BENCHMARK(Update_Fanout_Incr_Int_Dense)->Arg(64)->Arg(4096);
+
 static void Destroy_NoArgs_Const_Int(benchmark::State& state)
 {
   Engine engine;
@@ -192,6 +334,28 @@ static void Destroy_Unary_Incr_Int(benchmark::State& state)
 
 BENCHMARK(Destroy_Unary_Incr_Int);
 
+static void Destroy_Unary_Incr_Int_Pooled(benchmark::State& state)
+{
+  Engine engine{engine_options::fully_optimized |
+                engine_options::pooled_allocation};
+
+  const auto x = Var(1);
+
+  std::vector<ref<int>> tmp;
+
+  for (benchmark::IterationCount i = 0; i < state.max_iterations; ++i)
+  {
+    tmp.push_back(Incr(x));
+  }
+
+  for (auto _ : state)
+  {
+    tmp.pop_back();
+  }
+}
+
+BENCHMARK(Destroy_Unary_Incr_Int_Pooled);
+
 static void Destroy_Binary_Add_Int(benchmark::State& state)
 {
   Engine engine;
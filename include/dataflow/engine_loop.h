@@ -0,0 +1,87 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#ifndef DATAFLOW___ENGINE_LOOP_H
+#define DATAFLOW___ENGINE_LOOP_H
+
+#include "dataflow++_export.h"
+
+#include "prelude.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace dataflow
+{
+/// Engine with an event loop of its own, for applications without a GUI
+/// framework.
+///
+/// The loop drives real-time timers (including the ones of `Timeout()`) and
+/// delivers the values posted to variables from other threads. All the timers
+/// expired by the time the loop wakes up are processed by a single pump.
+///
+class DATAFLOW___EXPORT EngineLoop : public Engine
+{
+public:
+  using clock = std::chrono::steady_clock;
+  using timer_id = std::uint64_t;
+
+public:
+  explicit EngineLoop(
+    engine_options options = engine_options::fully_optimized);
+  ~EngineLoop();
+
+  /// Processes timers and posted values until `stop()` is called.
+  void run();
+
+  /// Processes the due timers and posted values without waiting.
+  void run_once();
+
+  /// Makes `run()` return. Thread-safe.
+  void stop();
+
+  /// Calls `callback` after `delay` and then every `period`, if it is not
+  /// zero. The callbacks of the timers expired together are called within
+  /// one batch.
+  timer_id start_timer(clock::duration delay,
+                       std::function<void()> callback,
+                       clock::duration period = clock::duration::zero());
+
+  /// Calls `callback` at `deadline`.
+  timer_id start_timer_at(clock::time_point deadline,
+                          std::function<void()> callback);
+
+  /// Returns `false` if the timer has already expired or been stopped.
+  bool stop_timer(timer_id id);
+
+private:
+  virtual ref<bool> timeout_(const ref<integer>& interval_msec,
+                             dtime t0) override;
+
+private:
+  class impl;
+
+  std::unique_ptr<impl> p_impl_;
+};
+}
+
+#endif // DATAFLOW___ENGINE_LOOP_H
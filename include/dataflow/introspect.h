@@ -29,11 +29,13 @@
 #include <boost/graph/graph_traits.hpp>
 #endif
 
+#include <chrono>
 #include <cstddef>
 #include <iterator>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace dataflow
 {
@@ -194,6 +196,7 @@ DATAFLOW___EXPORT dependency_graph::vertices_size_type num_changed_nodes();
 
 DATAFLOW___EXPORT dependency_graph::vertices_size_type num_updated_nodes();
 
+/// Memory allocated by the engine of the calling thread.
 DATAFLOW___EXPORT std::size_t memory_consumption();
 
 /// \name Data nodes properties
@@ -285,6 +288,87 @@ void DATAFLOW___EXPORT write_graphviz(std::ostream& out);
 
 void DATAFLOW___EXPORT write_graphviz();
 
+/// \name Profiling
+/// \{
+
+/// Update statistics of all the nodes sharing the same label.
+///
+/// \see engine_options::profiling
+struct node_profile
+{
+  std::string label;
+  std::size_t updates_count;
+  std::chrono::nanoseconds total_update_time;
+  std::chrono::nanoseconds max_update_time;
+  std::size_t activations_count;
+  std::size_t deactivations_count;
+};
+
+/// Gets at most `count` profiles with the greatest total update time, in
+/// descending order. Requires the engine to be started with
+/// `engine_options::profiling`.
+DATAFLOW___EXPORT std::vector<node_profile> hottest_nodes(std::size_t count);
+
+DATAFLOW___EXPORT void reset_profile();
+
+DATAFLOW___EXPORT void write_profile(std::ostream& out, std::size_t count = 10);
+
+/// \}
+
+/// \name Tracing
+/// \{
+
+/// Starts recording pumps, their rounds, updates of the nodes and activations
+/// of the subgraphs. Previously recorded events are discarded.
+///
+/// \param capacity The number of the latest events to keep; `0` keeps all
+///                 the events.
+DATAFLOW___EXPORT void start_tracing(std::size_t capacity = 0);
+
+DATAFLOW___EXPORT void stop_tracing();
+
+/// Writes the recorded events in the Chrome trace event format, which can be
+/// opened with `chrome://tracing` or Perfetto.
+DATAFLOW___EXPORT void write_trace(std::ostream& out);
+
+DATAFLOW___EXPORT void write_trace(const std::string& file_name);
+
+/// \}
+
+/// \name Pump statistics
+/// \{
+
+/// Statistics of a pump, summed over all its rounds.
+///
+/// Allocations are the ones made by the engine on the calling thread.
+struct pump_stats
+{
+  std::size_t tick;
+  std::size_t rounds_count;
+  std::size_t updated_nodes_count;
+  std::size_t changed_nodes_count;
+  std::size_t activations_count;
+  std::size_t deactivations_count;
+  std::size_t topological_moves_count;
+  std::size_t allocations_count;
+  std::size_t allocated_bytes;
+  std::chrono::nanoseconds wall_time;
+};
+
+/// Keeps the statistics of the latest `capacity` pumps. The history is
+/// discarded; zero capacity (the default) stops collecting the statistics.
+DATAFLOW___EXPORT void set_pump_history_capacity(std::size_t capacity);
+
+/// Gets the kept statistics from the oldest to the latest pump.
+DATAFLOW___EXPORT std::vector<pump_stats> pump_history();
+
+/// Gets the `percentile` (0 to 100) of every field of the kept statistics
+/// separately, using the nearest-rank method. The `tick` is the one of the
+/// latest pump. All the fields are zero if the history is empty.
+DATAFLOW___EXPORT pump_stats pump_history_percentile(double percentile);
+
+/// \}
+
 } // introspect
 } // dataflow
 
@@ -130,6 +130,8 @@ public:
 
   list<T> apply(list<T> v) const;
 
+  list_patch compose(const list_patch& next) const;
+
   bool empty() const;
 
 private:
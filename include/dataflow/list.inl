@@ -301,6 +301,17 @@ template <typename T> list<T> list_patch<T>::apply(list<T> v) const
   return v;
 }
 
+template <typename T>
+list_patch<T> list_patch<T>::compose(const list_patch& next) const
+{
+  auto result = *this;
+
+  next.apply([&](const integer& idx, const T& x) { result.insert(idx, x); },
+             [&](const integer& idx) { result.erase(idx); });
+
+  return result;
+}
+
 template <typename T> bool list_patch<T>::empty() const
 {
   return changes_.empty();
@@ -26,10 +26,12 @@
 #include "core/dtime.h"
 #include "core/engine_options.h"
 
+#include "core/internal/inbox.h"
 #include "core/internal/ref.h"
 
 #include <dataflow/utility/std_future.h>
 
+#include <chrono>
 #include <functional>
 #include <string>
 #include <type_traits>
@@ -134,15 +136,73 @@ public:
   const T& operator*() const;
 };
 
+/// Owns the dependency graph and all the nodes created in the calling thread.
+///
+/// Every thread can run its own engine. Nodes belong to the engine of the
+/// thread they were created in and must be used and released only there.
+///
 class DATAFLOW___EXPORT Engine
 {
   DATAFLOW___EXPORT friend ref<bool> Timeout(const arg<integer>& interval_msec,
                                              dtime t0);
 
+public:
+  /// Defers the updates caused by the assignments to variables until the
+  /// batch is committed, so that all of them are processed by a single pump.
+  /// Nested batches are merged into the outermost one. Exceptions thrown by
+  /// the nodes during the pump propagate from `commit()`. A batch destroyed
+  /// without a commit is not pumped, its updates are processed by the next
+  /// pump.
+  ///
+  class DATAFLOW___EXPORT Batch final
+  {
+  public:
+    Batch();
+    ~Batch();
+
+    Batch(const Batch&) = delete;
+    Batch& operator=(const Batch&) = delete;
+
+    void commit();
+
+  private:
+    bool committed_;
+  };
+
 public:
   Engine(engine_options options = engine_options::fully_optimized);
   virtual ~Engine();
 
+  /// Applies the values posted to variables from other threads and pumps.
+  void deliver_posted();
+
+  /// Keeps the branches of `If()` left after a condition change parked for
+  /// another `pumps` pumps, so that changing the condition back does not
+  /// rebuild them. Parked branches keep their values and their place in the
+  /// dependency order, but are not updated. When the condition changes back,
+  /// only the nodes that missed changes of their arguments are updated.
+  /// Nodes also used outside of the branch are updated as usual. Branches
+  /// given by functions of time are always rebuilt. At most `max_branches`
+  /// branches are kept, the oldest ones are deactivated first. Zero `pumps`
+  /// turns this off (the default).
+  void set_branch_retention(std::size_t pumps, std::size_t max_branches = 16);
+
+  /// Interrupts the pumps lasting longer than `budget`, leaving the rest of
+  /// the updates for `resume_pump()`. Until the pump is complete the values of
+  /// the nodes may be inconsistent with each other. Changes of variables made
+  /// meanwhile join the interrupted pump, which is continued within the
+  /// budget, so some nodes may be updated twice by it. Creation of active
+  /// nodes and removal of nodes complete the interrupted pump first, without
+  /// the budget. Zero `budget` turns this off (the default).
+  void set_pump_budget(std::chrono::microseconds budget);
+
+  /// Continues the interrupted pump within the budget. Returns `true` if the
+  /// pump is complete.
+  bool resume_pump();
+
+  /// Tells whether there is no interrupted pump.
+  bool settled() const;
+
 protected:
   static Engine* engine_();
 
@@ -171,8 +231,26 @@ protected:
   var_base(DATAFLOW_VAR_CONST var_base& other);
 
   void set_value_(const T& v) DATAFLOW_VAR_CONST;
+  void set_value_(T&& v) DATAFLOW_VAR_CONST;
 
   template <typename Patch> void set_patch_(const Patch& patch);
+
+  void post_value_(const T& v) DATAFLOW_VAR_CONST;
+  void post_value_(T&& v) DATAFLOW_VAR_CONST;
+
+  template <typename Patch> void post_patch_(const Patch& patch);
+
+private:
+  template <typename U> void assign_(U&& v) DATAFLOW_VAR_CONST;
+
+  // Posts `f` to be called with the variable by the engine thread, unless the
+  // variable node is gone by then
+  template <typename F> void post_(bool overwrites, F f) DATAFLOW_VAR_CONST;
+
+private:
+  internal::inbox* p_inbox_;
+  // Stays with the messages posted to the variable
+  std::uint32_t generation_;
 };
 }
 
@@ -195,6 +273,30 @@ public:
 
     return *this;
   }
+
+  DATAFLOW_VAR_CONST var& operator=(T&& v) DATAFLOW_VAR_CONST
+  {
+    core::var_base<T>::set_value_(std::move(v));
+
+    return *this;
+  }
+
+  /// Assigns `v` to the variable from any thread.
+  ///
+  /// The value is applied by the engine thread at the beginning of the next
+  /// pump or by `Engine::deliver_posted()`. Only the last of several values
+  /// posted to the same variable is applied. The value is dropped if the
+  /// variable node is destroyed before that.
+  ///
+  void post(const T& v) DATAFLOW_VAR_CONST
+  {
+    core::var_base<T>::post_value_(v);
+  }
+
+  void post(T&& v) DATAFLOW_VAR_CONST
+  {
+    core::var_base<T>::post_value_(std::move(v));
+  }
 };
 
 template <typename T> using init_function = std::function<ref<T>(dtime)>;
@@ -208,6 +310,8 @@ public:
 
   T apply(const T& prev) const;
 
+  generic_patch compose(const generic_patch& next) const;
+
 private:
   T curr_;
 };
@@ -711,6 +815,31 @@ template <typename Policy,
           typename T = std20::remove_cvref_t<
             decltype(std::declval<Policy>().calculate(std::declval<Xs>()...))>>
 ref<T> LiftPatcher(const ref<Xs>&... xs);
+
+/// Computes `policy.calculate(xs...)` on a background worker thread from the
+/// copies of the arguments. The computations in flight share the policy, so
+/// its `calculate()` must be const. The node keeps its last value (initially
+/// `T()`) until the result is delivered by the next pump or by
+/// `Engine::deliver_posted()`. Nothing wakes a plain `Engine` up when a
+/// result is ready, whereas `EngineLoop` delivers the results on its own.
+/// Results and exceptions of the computations from outdated arguments are
+/// discarded. A policy returning `maybe<U>` tells whether any result is
+/// available yet.
+template <
+  typename Policy,
+  typename X,
+  typename... Xs,
+  typename T = std20::remove_cvref_t<decltype(std::declval<Policy>().calculate(
+    std::declval<X>(), std::declval<Xs>()...))>>
+ref<T> LiftAsync(Policy policy, const ref<X>& x, const ref<Xs>&... xs);
+
+template <
+  typename Policy,
+  typename X,
+  typename... Xs,
+  typename T = std20::remove_cvref_t<decltype(std::declval<Policy>().calculate(
+    std::declval<X>(), std::declval<Xs>()...))>>
+ref<T> LiftAsync(const ref<X>& x, const ref<Xs>&... xs);
 }
 
 // Basic functions
@@ -752,6 +881,14 @@ val<T> Main(F f);
 
 template <typename T> val<T> Main(ref<T> x);
 
+/// Builds a subgraph with function `f` and compiles its static part (the nodes
+/// created with `Lift` that are not referenced from outside of `f`) into a flat
+/// program evaluated by a single node. Variables, conditional and shared nodes
+/// remain the inputs of the program.
+template <typename F,
+          typename T = core::data_type_t<decltype(std::declval<F>()())>>
+ref<T> Freeze(F f);
+
 // Conditional functions
 
 template <typename T,
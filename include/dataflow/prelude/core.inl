@@ -21,8 +21,10 @@
 #endif
 
 #include "core/internal/config.h"
+#include "core/internal/node_async.h"
 #include "core/internal/node_compound.h"
 #include "core/internal/node_const.h"
+#include "core/internal/node_frozen.h"
 #include "core/internal/node_if.h"
 #include "core/internal/node_if_activator.h"
 #include "core/internal/node_main.h"
@@ -104,6 +106,8 @@ namespace core
 template <typename T>
 var_base<T>::var_base(const internal::ref& r, internal::ref::ctor_guard_t)
 : ref<T>(core::ref_base<T>(r, internal::ref::ctor_guard))
+, p_inbox_(&this->get_inbox_())
+, generation_(this->node_generation_())
 {
 }
 
@@ -129,14 +133,57 @@ var_base<T>::var_base(DATAFLOW_VAR_CONST var_base& other) = default;
 
 template <typename T>
 void var_base<T>::set_value_(const T& v) DATAFLOW_VAR_CONST
+{
+  assign_(v);
+}
+
+template <typename T>
+void var_base<T>::set_value_(T&& v) DATAFLOW_VAR_CONST
+{
+  assign_(std::move(v));
+}
+
+template <typename T>
+template <typename U>
+void var_base<T>::assign_(U&& v) DATAFLOW_VAR_CONST
 {
   DATAFLOW___CHECK_PRECONDITION(
     dynamic_cast<const internal::node_var<T>*>(this->get_()));
 
   const auto p_var = static_cast<const internal::node_var<T>*>(this->get_());
 
-  if (p_var->set_next_value(v))
+  if (p_var->set_next_value(std::forward<U>(v)))
+  {
+    // Neither a patch set earlier in the same batch nor a later one describes
+    // the whole change, so the empty metadata is stored to make the consumers
+    // calculate the difference themselves. Later patches do not replace it.
+    if ((this->is_batching_() && !this->has_metadata()) ||
+        this->get_metadata())
+    {
+      this->set_metadata(nullptr);
+    }
+
     this->schedule_();
+  }
+}
+
+namespace detail
+{
+template <typename Patch>
+auto compose_patches(const Patch& first, const Patch& second, int)
+  -> decltype(std::declval<const Patch&>().compose(second),
+              std::unique_ptr<const internal::metadata>())
+{
+  return std::unique_ptr<const internal::metadata>(
+    new internal::patch_metadata<Patch>{first.compose(second)});
+}
+
+template <typename Patch>
+std::unique_ptr<const internal::metadata>
+compose_patches(const Patch&, const Patch&, ...)
+{
+  return nullptr;
+}
 }
 
 template <typename T>
@@ -150,14 +197,68 @@ void var_base<T>::set_patch_(const Patch& patch)
 
   if (p_var->set_next_value(patch.apply(p_var->next_value())))
   {
-
-    this->set_metadata(std::unique_ptr<const internal::metadata>(
-      new internal::patch_metadata<Patch>{patch}));
+    if (!this->has_metadata())
+    {
+      this->set_metadata(std::unique_ptr<const internal::metadata>(
+        new internal::patch_metadata<Patch>{patch}));
+    }
+    else if (const auto p_prev =
+               dynamic_cast<const internal::patch_metadata<Patch>*>(
+                 this->get_metadata().get()))
+    {
+      // Several patches within a batch are merged into one
+      this->set_metadata(detail::compose_patches(p_prev->patch, patch, 0));
+    }
+    else
+    {
+      this->set_metadata(nullptr);
+    }
 
     this->schedule_();
   }
 }
 
+template <typename T>
+void var_base<T>::post_value_(const T& v) DATAFLOW_VAR_CONST
+{
+  post_(true, [v](var_base& x) { x.set_value_(v); });
+}
+
+template <typename T>
+void var_base<T>::post_value_(T&& v) DATAFLOW_VAR_CONST
+{
+  post_(true, [v = std::move(v)](var_base& x) mutable {
+    x.set_value_(std::move(v));
+  });
+}
+
+template <typename T>
+template <typename Patch>
+void var_base<T>::post_patch_(const Patch& patch)
+{
+  post_(false, [patch](var_base& x) { x.set_patch_(patch); });
+}
+
+template <typename T>
+template <typename F>
+void var_base<T>::post_(bool overwrites, F f) DATAFLOW_VAR_CONST
+{
+  const auto id = this->id();
+
+  // The id alone may refer to another node by the time of the delivery
+  p_inbox_->post(internal::inbox::make_message(
+    id,
+    overwrites,
+    [id, generation = generation_, f = std::move(f)]() mutable {
+      if (!internal::ref::is_alive_(id, generation))
+        return;
+
+      var_base x(internal::ref::acquire_(id), internal::ref::ctor_guard);
+
+      f(x);
+    }));
+}
+
 template <typename T>
 generic_patch<T>::generic_patch(const T& curr, const T&)
 : curr_(curr)
@@ -169,6 +270,12 @@ template <typename T> T generic_patch<T>::apply(const T&) const
   return curr_;
 }
 
+template <typename T>
+generic_patch<T> generic_patch<T>::compose(const generic_patch& next) const
+{
+  return next;
+}
+
 template <typename T, typename Patch>
 diff<T, Patch>::diff(const T& curr, const T& prev, const Patch& patch)
 : curr_(curr)
@@ -316,8 +423,16 @@ namespace detail
 template <typename T, typename Policy, typename X, typename... Xs>
 ref<T> lift(Policy policy, const ref<X>& x, const ref<Xs>&... xs)
 {
+  // Copying aggregate values changes reference counters of the nodes, so
+  // only lifts over regular data types are allowed to be updated concurrently.
+  const auto flags = std17::conjunction<is_regular_data_type<T>,
+                                        is_regular_data_type<X>,
+                                        is_regular_data_type<Xs>...>::value
+                       ? internal::node_flags::concurrent
+                       : internal::node_flags::none;
+
   return ref<T>{ref_base<T>(internal::node_n_ary<Policy, T, X, Xs...>::create(
-                              std::move(policy), false, x, xs...),
+                              std::move(policy), flags, x, xs...),
                             internal::ref::ctor_guard)};
 }
 
@@ -374,9 +489,10 @@ ref<T> core::LiftUpdater(const ref<Xs>&... xs)
 template <typename Policy, typename X, typename... Xs, typename T>
 ref<T> core::LiftPuller(Policy policy, const ref<X>& x, const ref<Xs>&... xs)
 {
-  return ref<T>{ref_base<T>(internal::node_n_ary<Policy, T, X, Xs...>::create(
-                              std::move(policy), true, x, xs...),
-                            internal::ref::ctor_guard)};
+  return ref<T>{
+    ref_base<T>(internal::node_n_ary<Policy, T, X, Xs...>::create(
+                  std::move(policy), internal::node_flags::eager, x, xs...),
+                internal::ref::ctor_guard)};
 }
 
 template <typename Policy, typename X, typename... Xs, typename T>
@@ -468,6 +584,32 @@ ref<T> core::LiftPatcher(const ref<Xs>&... xs)
 {
   return LiftPatcher(Policy(), xs...);
 }
+
+template <typename Policy, typename X, typename... Xs, typename T>
+ref<T> core::LiftAsync(Policy policy, const ref<X>& x, const ref<Xs>&... xs)
+{
+  // Copying aggregate values changes reference counters of the nodes, which
+  // is not allowed on the worker threads
+  static_assert(std17::conjunction<is_regular_data_type<T>,
+                                   is_regular_data_type<X>,
+                                   is_regular_data_type<Xs>...>::value,
+                "Only regular data types can be used with `LiftAsync()`");
+
+  // The computations in flight share the policy
+  static_assert(internal::has_const_calculate<Policy, X, Xs...>::value,
+                "`LiftAsync()` requires `calculate()` of the policy to be "
+                "const");
+
+  return ref<T>{ref_base<T>(internal::node_async<Policy, T, X, Xs...>::create(
+                              std::move(policy), x, xs...),
+                            internal::ref::ctor_guard)};
+}
+
+template <typename Policy, typename X, typename... Xs, typename T>
+ref<T> core::LiftAsync(const ref<X>& x, const ref<Xs>&... xs)
+{
+  return LiftAsync<Policy>(Policy(), x, xs...);
+}
 }
 
 // Basic functions
@@ -531,6 +673,12 @@ template <typename T> dataflow::val<T> dataflow::Main(ref<T> x)
   return Main([x](dtime) { return x; });
 }
 
+template <typename F, typename T> dataflow::ref<T> dataflow::Freeze(F f)
+{
+  return ref<T>{core::ref_base<T>(internal::node_frozen<T>::create(f()),
+                                  internal::ref::ctor_guard)};
+}
+
 template <typename T, typename U, typename FwT, typename>
 dataflow::ref<FwT> dataflow::If(const ref<bool>& x, const T& y, const U& z)
 {
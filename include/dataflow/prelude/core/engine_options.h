@@ -24,10 +24,51 @@ namespace dataflow
 /// \ingroup prelude
 /// \{
 
+/// Options controlling the behavior of the dataflow engine.
+///
+/// `fully_optimized` enables `straight_update_optimization` only. The other
+/// options make assumptions about the policies or trade memory for speed, so
+/// they have to be requested explicitly.
+///
+/// `parallel_update` updates the independent nodes of a topological level
+/// concurrently on a thread pool shared by all the engines. Only the nodes of
+/// `core::Lift()` over regular data types are updated this way, so their
+/// policies must be thread-safe. `straight_update_optimization` is not applied
+/// to these updates.
+///
+/// `pooled_allocation` takes nodes, edges and list elements from size-class
+/// slabs kept until the engine is destroyed.
+///
+/// `chain_fusion` propagates a change through a chain of `core::Lift()` nodes,
+/// each being the only consumer of the previous one, without scheduling them.
+///
+/// `common_subexpression_elimination` reuses the node of `core::Lift()` with
+/// a stateless policy of the same type over the same arguments.
+///
+/// `constant_folding` computes `core::Lift()` with a stateless policy over
+/// constant arguments immediately and returns a constant.
+///
+/// `retain_values` keeps the values of deactivated `core::Lift()` and `Var()`
+/// nodes and reuses them on activation if the arguments have not changed.
+///
+/// `dense_scheduling` keeps the nodes scheduled for update in a bitset indexed
+/// by their topological ranks instead of a heap.
+///
+/// `profiling` measures the updates of the nodes, see
+/// `introspect::hottest_nodes()`.
+///
 enum class engine_options
 {
   nothing = 0x00,
   straight_update_optimization = 0x01,
+  parallel_update = 0x02,
+  pooled_allocation = 0x04,
+  chain_fusion = 0x08,
+  common_subexpression_elimination = 0x10,
+  constant_folding = 0x20,
+  retain_values = 0x40,
+  dense_scheduling = 0x80,
+  profiling = 0x100,
   fully_optimized = 0x01,
 };
 
@@ -0,0 +1,132 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "dataflow++_export.h"
+
+#include "config.h"
+#include "node.h"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <unordered_set>
+#include <utility>
+
+namespace dataflow
+{
+namespace internal
+{
+/// Lock-free queue of updates posted to an engine from other threads.
+///
+/// Any thread can post messages, only the engine thread delivers them.
+///
+class DATAFLOW___EXPORT inbox final
+{
+public:
+  class DATAFLOW___EXPORT message
+  {
+    friend class inbox;
+
+  public:
+    /// `overwrites` tells that the message makes all the earlier messages
+    /// addressed to the same node obsolete (e.g. it assigns a new value).
+    explicit message(node_id id, bool overwrites);
+    virtual ~message();
+
+    message(const message&) = delete;
+    message& operator=(const message&) = delete;
+
+    virtual void deliver() = 0;
+
+  private:
+    message* p_next_;
+    const node_id id_;
+    const bool overwrites_;
+  };
+
+  template <typename F> class function_message;
+
+public:
+  inbox();
+  ~inbox() noexcept;
+
+  inbox(const inbox&) = delete;
+  inbox& operator=(const inbox&) = delete;
+
+  template <typename F>
+  static std::unique_ptr<message>
+  make_message(node_id id, bool overwrites, F&& f);
+
+  /// Thread-safe.
+  void post(std::unique_ptr<message> p_message);
+
+  /// Thread-safe.
+  bool empty() const;
+
+  /// Sets a function called by the posting thread after posting to an empty
+  /// inbox, e.g. to wake up the engine thread. Not thread-safe.
+  void set_wakeup(std::function<void()> wakeup);
+
+  /// Delivers the messages in the order they were posted. Messages made
+  /// obsolete by later ones are dropped without delivery. If a message throws,
+  /// the remaining ones are still delivered and the first exception is
+  /// rethrown.
+  ///
+  /// Returns the number of delivered messages.
+  ///
+  std::size_t deliver();
+
+private:
+  // Posted messages, the most recent first
+  std::atomic<message*> p_head_;
+  std::unordered_set<node_id> overwritten_;
+  std::function<void()> wakeup_;
+};
+
+template <typename F> class inbox::function_message final : public message
+{
+public:
+  function_message(node_id id, bool overwrites, F f)
+  : message(id, overwrites)
+  , f_(std::move(f))
+  {
+  }
+
+  void deliver() override
+  {
+    f_();
+  }
+
+private:
+  F f_;
+};
+
+template <typename F>
+std::unique_ptr<inbox::message>
+inbox::make_message(node_id id, bool overwrites, F&& f)
+{
+  using message_type = function_message<typename std::decay<F>::type>;
+
+  return std::unique_ptr<message>(
+    new message_type(id, overwrites, std::forward<F>(f)));
+}
+} // internal
+} // dataflow
@@ -102,18 +102,30 @@ public:
     return update_(id, initialized, p_args, args_count);
   }
 
-  void deactivate(node_id id)
+  /// Deactivates the node. A retainable node may be asked to keep its value,
+  /// which is then reused on the next activation.
+  void deactivate(node_id id, bool retain_value = false)
   {
     DATAFLOW___CHECK_PRECONDITION_DEBUG(activation_count_ ==
                                         deactivation_count_ + 1);
+    DATAFLOW___CHECK_PRECONDITION(!retain_value || retainable_());
 
-    deactivate_(id);
+    if (!retain_value)
+      deactivate_(id);
 
 #ifndef NDEBUG
     ++deactivation_count_;
 #endif
   }
 
+  /// Tells whether the value of the node stays valid while it is inactive,
+  /// since it depends only on the values of its arguments (or, if there are no
+  /// arguments, is set from outside).
+  bool retainable() const
+  {
+    return retainable_();
+  }
+
   std::string label() const
   {
     return label_();
@@ -164,6 +176,11 @@ private:
   {
   }
 
+  virtual bool retainable_() const
+  {
+    return false;
+  }
+
   virtual std::string label_() const = 0;
 
   virtual std::string to_string_() const = 0;
@@ -0,0 +1,201 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <dataflow++_export.h>
+
+#include "node_t.h"
+#include "nodes_factory.h"
+#include "ref.h"
+
+#include <dataflow/utility/std_future.h>
+
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+namespace dataflow
+{
+namespace internal
+{
+/// Calls `job` on a background worker thread of the current engine. The
+/// function returned by `job` is called back on the engine thread, when the
+/// posted messages are delivered, and node `id` is scheduled for update if it
+/// returns `true`. An exception thrown by `job` is rethrown on delivery, so
+/// the jobs catch the ones that may turn out to be stale themselves.
+DATAFLOW___EXPORT void
+run_node_async(node_id id, std::function<std::function<bool()>()> job);
+
+template <typename Policy, typename T, typename... Xs>
+class node_async final : public node_t<T>
+{
+  friend class nodes_factory;
+
+public:
+  static ref create(Policy policy, ref_t<Xs>... xs)
+  {
+    DATAFLOW___CHECK_PRECONDITION(
+      check_all_of(xs.template is_of_type<Xs>()...));
+
+    const std::array<node_id, sizeof...(Xs)> args = {{xs.id()...}};
+
+    return nodes_factory::create<node_async<Policy, T, Xs...>>(
+      &args[0], args.size(), node_flags::none, std::move(policy));
+  }
+
+private:
+  // Shared with the computations in flight, accessed on the engine thread
+  struct result
+  {
+    bool alive;
+    std::uint64_t generation;
+    bool ready;
+    T value;
+  };
+
+  explicit node_async(Policy policy)
+  : p_policy_(std::make_shared<const Policy>(std::move(policy)))
+  , p_result_(std::make_shared<result>(result{true, 0, false, T()}))
+  , args_()
+  {
+  }
+
+  ~node_async()
+  {
+    p_result_->alive = false;
+  }
+
+  template <std::size_t... Is>
+  static T calculate_(const Policy& policy,
+                      const std::tuple<Xs...>& args,
+                      const std14::index_sequence<Is...>&)
+  {
+    return policy.calculate(std::get<Is>(args)...);
+  }
+
+  template <std::size_t... Is>
+  static std::tuple<Xs...> extract_args_(const node** p_args,
+                                         const std14::index_sequence<Is...>&)
+  {
+    return std::tuple<Xs...>(extract_node_value<Xs>(p_args[Is])...);
+  }
+
+  // Starts the computation from the current arguments. Results of the earlier
+  // computations become stale.
+  void submit_(node_id id)
+  {
+    const auto generation = ++p_result_->generation;
+
+    p_result_->ready = false;
+
+    run_node_async(
+      id,
+      [p_policy = p_policy_,
+       args = args_,
+       p_result = p_result_,
+       generation]() -> std::function<bool()> {
+        T value;
+        std::exception_ptr p_error;
+
+        try
+        {
+          value = calculate_(
+            *p_policy, args, std14::make_index_sequence<sizeof...(Xs)>());
+        }
+        catch (...)
+        {
+          p_error = std::current_exception();
+        }
+
+        return [p_result, generation, value, p_error]() mutable {
+          if (!p_result->alive || p_result->generation != generation)
+            return false;
+
+          if (p_error)
+            std::rethrow_exception(p_error);
+
+          p_result->value = std::move(value);
+          p_result->ready = true;
+
+          return true;
+        };
+      });
+  }
+
+  virtual update_status update_(node_id id,
+                                bool initialized,
+                                const node** p_args,
+                                std::size_t args_count) override
+  {
+    DATAFLOW___CHECK_PRECONDITION(p_args != nullptr);
+    DATAFLOW___CHECK_PRECONDITION(args_count == sizeof...(Xs));
+
+    auto args =
+      extract_args_(p_args, std14::make_index_sequence<sizeof...(Xs)>());
+
+    if (!initialized || args != args_)
+    {
+      args_ = std::move(args);
+
+      submit_(id);
+
+      return update_status::nothing;
+    }
+
+    if (!p_result_->ready)
+      return update_status::nothing;
+
+    p_result_->ready = false;
+
+    return this->set_value_(std::move(p_result_->value));
+  }
+
+  virtual void deactivate_(node_id id) override
+  {
+    // Discards the computation in flight
+    ++p_result_->generation;
+    p_result_->ready = false;
+
+    args_ = std::tuple<Xs...>();
+
+    node_t<T>::perform_deactivation_();
+  }
+
+  virtual std::string label_() const override
+  {
+    return p_policy_->label();
+  }
+
+  virtual std::pair<std::size_t, std::size_t> mem_info_() const override final
+  {
+    return std::make_pair(sizeof(*this), alignof(decltype(*this)));
+  }
+
+private:
+  // The policy is shared with the computations in flight as well
+  std::shared_ptr<const Policy> p_policy_;
+  std::shared_ptr<result> p_result_;
+  std::tuple<Xs...> args_;
+};
+} // internal
+} // dataflow
@@ -0,0 +1,140 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <dataflow++_export.h>
+
+#include "node_t.h"
+#include "nodes_factory.h"
+#include "ref.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace dataflow
+{
+namespace internal
+{
+/// Static part of a subgraph compiled into a flat program.
+///
+/// The program takes over the inactive nodes of the subgraph that compute
+/// their values from their arguments only and are not referenced from outside
+/// of it. The rest of the nodes (variables, constants, conditional nodes and
+/// the shared ones) become the inputs of the program and stay in the engine.
+/// The nodes of the program are stored in topological order together with
+/// their operands in the compressed sparse row form. A node is updated only if
+/// one of its operands has changed.
+///
+class DATAFLOW___EXPORT frozen_program final
+{
+public:
+  explicit frozen_program(const ref& x);
+
+  bool empty() const;
+
+  const std::vector<node_id>& inputs() const;
+
+  void activate(const discrete_time& t0);
+
+  // Updates the program. Returns the node holding the result.
+  const node*
+  run(const node** p_inputs, std::size_t inputs_count, bool initialized);
+
+  void deactivate();
+
+private:
+  ref root_;
+  std::vector<node_id> inputs_;
+  std::vector<node*> nodes_;
+  std::vector<node_id> ids_;
+  // Operands of `nodes_[i]` are in `operands_` between `offsets_[i]` and
+  // `offsets_[i + 1]`. Operands below `inputs_.size()` refer to the inputs,
+  // the others to the nodes.
+  std::vector<std::size_t> offsets_;
+  std::vector<std::size_t> operands_;
+  std::vector<bool> changed_;
+  std::vector<const node*> args_;
+  std::uint64_t last_run_;
+};
+
+template <typename T> class node_frozen final : public node_t<T>
+{
+  friend class nodes_factory;
+
+public:
+  static ref create(const ref& x)
+  {
+    DATAFLOW___CHECK_PRECONDITION(x.template is_of_type<T>());
+
+    frozen_program program(x);
+
+    if (program.empty())
+      return x;
+
+    // The program is moved into the node before the arguments are used
+    const auto inputs = program.inputs();
+
+    return nodes_factory::create<node_frozen<T>>(
+      &inputs[0], inputs.size(), node_flags::none, std::move(program));
+  }
+
+private:
+  explicit node_frozen(frozen_program program)
+  : program_(std::move(program))
+  {
+  }
+
+  virtual void activate_(node_id id, const discrete_time& t0) override
+  {
+    program_.activate(t0);
+  }
+
+  virtual update_status update_(node_id id,
+                                bool initialized,
+                                const node** p_args,
+                                std::size_t args_count) override
+  {
+    return this->set_value_(extract_node_value<T>(
+      program_.run(p_args, args_count, initialized)));
+  }
+
+  virtual void deactivate_(node_id id) override
+  {
+    program_.deactivate();
+
+    node_t<T>::perform_deactivation_();
+  }
+
+  virtual std::string label_() const override
+  {
+    return "frozen";
+  }
+
+  virtual std::pair<std::size_t, std::size_t> mem_info_() const override final
+  {
+    return std::make_pair(sizeof(*this), alignof(decltype(*this)));
+  }
+
+private:
+  frozen_program program_;
+};
+} // internal
+} // dataflow
@@ -63,14 +63,20 @@ private:
                                 std::size_t args_count) override
   {
     DATAFLOW___CHECK_PRECONDITION(p_args != nullptr);
-    DATAFLOW___CHECK_PRECONDITION(args_count == 2);
+    DATAFLOW___CHECK_PRECONDITION(args_count == 2 || args_count == 3);
 
-    if (initialized && p_prev_branch_ == p_args[1])
-      node::set_metadata(this, node::get_metadata(p_args[1]));
+    // Both branches are active while the previous one is kept warm (see
+    // `Engine::set_branch_retention()`), then the condition selects one
+    const auto p_branch =
+      args_count == 2 ? p_args[1]
+                      : p_args[extract_node_value<bool>(p_args[0]) ? 2 : 1];
 
-    p_prev_branch_ = p_args[1];
+    if (initialized && p_prev_branch_ == p_branch)
+      node::set_metadata(this, node::get_metadata(p_branch));
 
-    return this->set_value_(extract_node_value<T>(p_args[1]));
+    p_prev_branch_ = p_branch;
+
+    return this->set_value_(extract_node_value<T>(p_branch));
   }
 
   virtual void deactivate_(node_id id) override
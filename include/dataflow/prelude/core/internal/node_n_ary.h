@@ -19,6 +19,7 @@
 #pragma once
 
 #include "config.h"
+#include "node_const.h"
 #include "node_t.h"
 #include "nodes_factory.h"
 #include "ref.h"
@@ -26,6 +27,7 @@
 #include <dataflow/utility/std_future.h>
 
 #include <array>
+#include <type_traits>
 #include <utility>
 
 namespace dataflow
@@ -39,17 +41,24 @@ class node_n_ary final : public node_t<T>, public Policy
   friend class nodes_factory;
 
 public:
-  static ref create(Policy policy, bool eager, ref_t<Xs>... xs)
+  static ref create(Policy policy, node_flags flags, ref_t<Xs>... xs)
   {
     DATAFLOW___CHECK_PRECONDITION(
       check_all_of(xs.template is_of_type<Xs>()...));
 
     const std::array<node_id, sizeof...(Xs)> args = {{xs.id()...}};
 
+    // Only stateless policies are assumed to be pure
+    if (std::is_empty<Policy>::value &&
+        (flags & node_flags::pump) == node_flags::none &&
+        nodes_factory::can_fold(&args[0], args.size()))
+      return node_const<T>::create(
+        policy.calculate(xs.template value<Xs>()...));
+
     return nodes_factory::create<node_n_ary<Policy, T, Xs...>>(
       &args[0],
       args.size(),
-      eager ? node_flags::eager : node_flags::none,
+      flags,
       std::move(policy));
   }
 
@@ -59,6 +68,12 @@ private:
   {
   }
 
+  ~node_n_ary()
+  {
+    // The value can be retained after the deactivation
+    node_t<T>::perform_deactivation_();
+  }
+
   template <typename... Args, std::size_t... Is>
   T calculate_(const node** p_args, const std14::index_sequence<Is...>&)
   {
@@ -77,6 +92,11 @@ private:
       calculate_<Xs...>(p_args, std14::make_index_sequence<sizeof...(Xs)>()));
   }
 
+  virtual bool retainable_() const override
+  {
+    return true;
+  }
+
   virtual std::string label_() const override
   {
     return Policy::label();
@@ -87,5 +107,11 @@ private:
     return std::make_pair(sizeof(*this), alignof(decltype(*this)));
   }
 };
+
+// Stateless policies compute the same values from the same arguments
+template <typename Policy, typename T, typename... Xs>
+struct is_shareable_node<node_n_ary<Policy, T, Xs...>> : std::is_empty<Policy>
+{
+};
 } // internal
 } // dataflow
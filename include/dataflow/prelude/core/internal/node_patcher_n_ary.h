@@ -118,9 +118,7 @@ private:
                          std::unique_ptr<patch_metadata<OutPatch>>{
                            new patch_metadata<OutPatch>{patch}});
 
-      const auto v = patch.apply(this->value());
-
-      return this->set_value_(v);
+      return this->set_value_(patch.apply(this->value()));
     }
 
     return this->set_value_(initialize_<typename InDiffs::data_type...>(
@@ -24,6 +24,7 @@
 
 #include <algorithm>
 #include <sstream>
+#include <utility>
 
 namespace dataflow
 {
@@ -57,6 +58,25 @@ inline std::string node_value_to_string(const std::string& value)
 
   return out.str();
 }
+
+template <typename T>
+bool node_values_equal(const T& lhs, const T& rhs, std::false_type)
+{
+  return lhs == rhs;
+}
+
+template <typename T>
+bool node_values_equal(const T& lhs, const T& rhs, std::true_type)
+{
+  return lhs.version() == rhs.version();
+}
+}
+
+// Versioned values are compared by their version stamps
+template <typename T> bool node_values_equal(const T& lhs, const T& rhs)
+{
+  return detail::node_values_equal(
+    lhs, rhs, std::integral_constant<bool, is_versioned<T>::value>());
 }
 
 template <typename T> class node_t : public node
@@ -95,9 +115,10 @@ protected:
     DATAFLOW___CHECK_CONDITION_DEBUG(value_ == T{});
   }
 
+  // Only the comparison is cheap for versioned values, the copy is not
   update_status set_value_(const T& v)
   {
-    if (value_ == v)
+    if (node_values_equal(value_, v))
       return update_status::nothing;
 
     value_ = v;
@@ -105,6 +126,16 @@ protected:
     return update_status::updated;
   }
 
+  update_status set_value_(T&& v)
+  {
+    if (node_values_equal(value_, v))
+      return update_status::nothing;
+
+    value_ = std::move(v);
+
+    return update_status::updated;
+  }
+
   void perform_deactivation_()
   {
     value_ = T{};
@@ -81,14 +81,14 @@ private:
     DATAFLOW___CHECK_PRECONDITION(p_args != nullptr);
     DATAFLOW___CHECK_PRECONDITION(args_count == sizeof...(Xs));
 
-    const auto new_value =
+    auto new_value =
       initialized
         ? update_<Xs...>(
             this->value(), p_args, std14::make_index_sequence<sizeof...(Xs)>())
         : calculate_<Xs...>(p_args,
                             std14::make_index_sequence<sizeof...(Xs)>());
 
-    return this->set_value_(new_value);
+    return this->set_value_(std::move(new_value));
   }
 
   virtual std::string label_() const override
@@ -41,7 +41,7 @@ public:
 
   bool set_next_value(const T& v) const
   {
-    if (next_value_ == v)
+    if (node_values_equal(next_value_, v))
       return false;
 
     next_value_ = v;
@@ -49,6 +49,16 @@ public:
     return true;
   }
 
+  bool set_next_value(T&& v) const
+  {
+    if (node_values_equal(next_value_, v))
+      return false;
+
+    next_value_ = std::move(v);
+
+    return true;
+  }
+
   const T& next_value() const
   {
     return next_value_;
@@ -61,6 +71,12 @@ private:
   {
   }
 
+  ~node_var()
+  {
+    // The value can be retained after the deactivation
+    node_t<T>::perform_deactivation_();
+  }
+
   virtual update_status update_(node_id id,
                                 bool initialized,
                                 const node** p_args,
@@ -69,6 +85,11 @@ private:
     return this->set_value_(next_value_);
   }
 
+  virtual bool retainable_() const override
+  {
+    return true;
+  }
+
   virtual std::string label_() const override
   {
     return "var";
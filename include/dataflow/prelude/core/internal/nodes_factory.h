@@ -22,9 +22,11 @@
 
 #include "ref.h"
 
-#include <cstddef> // std::size_t
-#include <memory>  // std::addressof
-#include <utility> // std::forward
+#include <cstddef>     // std::size_t
+#include <memory>      // std::addressof
+#include <type_traits> // std::false_type, std::true_type
+#include <typeinfo>    // std::type_info
+#include <utility>     // std::forward
 
 namespace dataflow
 {
@@ -36,7 +38,8 @@ enum class node_flags
 {
   none = 0x00,
   eager = 0x01,
-  pump = 0x02
+  pump = 0x02,
+  concurrent = 0x04
 };
 
 inline node_flags operator|(node_flags lhs, node_flags rhs)
@@ -65,6 +68,12 @@ inline node_flags& operator&=(node_flags& lhs, node_flags rhs)
   return lhs = lhs & rhs;
 }
 
+/// Tells whether nodes of type `Node` having the same arguments and flags are
+/// interchangeable, so that a single node can be shared among all of them.
+template <typename Node> struct is_shareable_node : std::false_type
+{
+};
+
 class DATAFLOW___EXPORT nodes_factory
 {
 public:
@@ -74,8 +83,12 @@ public:
                     node_flags flags,
                     Args&&... args)
   {
-    return add_(
-      new_node_<Node>(std::forward<Args>(args)...), p_args, args_count, flags);
+    return create_<Node>(
+      std::integral_constant<bool, is_shareable_node<Node>::value>(),
+      p_args,
+      args_count,
+      flags,
+      std::forward<Args>(args)...);
   }
 
   template <typename Node, typename... Args>
@@ -99,7 +112,40 @@ public:
     return get_time_();
   }
 
+  /// Tells whether a pure function of the given arguments can be evaluated
+  /// right away and stored in a constant node instead of a regular one.
+  static bool can_fold(const node_id* p_args, std::size_t args_count);
+
 private:
+  template <typename Node, typename... Args>
+  static ref create_(std::false_type,
+                     const node_id* p_args,
+                     std::size_t args_count,
+                     node_flags flags,
+                     Args&&... args)
+  {
+    return add_(
+      new_node_<Node>(std::forward<Args>(args)...), p_args, args_count, flags);
+  }
+
+  template <typename Node, typename... Args>
+  static ref create_(std::true_type,
+                     const node_id* p_args,
+                     std::size_t args_count,
+                     node_flags flags,
+                     Args&&... args)
+  {
+    const auto id = find_shared_(typeid(Node), p_args, args_count, flags);
+
+    if (id != node_id())
+      return ref(id);
+
+    return add_shared_(new_node_<Node>(std::forward<Args>(args)...),
+                       p_args,
+                       args_count,
+                       flags);
+  }
+
   template <typename Node, typename... Args>
   static Node* new_node_(Args&&... args)
   {
@@ -126,6 +172,14 @@ private:
                   const node_id* p_args,
                   std::size_t args_count,
                   node_flags flags);
+  static node_id find_shared_(const std::type_info& type,
+                              const node_id* p_args,
+                              std::size_t args_count,
+                              node_flags flags);
+  static ref add_shared_(node* p_node,
+                         const node_id* p_args,
+                         std::size_t args_count,
+                         node_flags flags);
   static ref add_conditional_(node* p_node,
                               const node_id* p_args,
                               std::size_t args_count,
@@ -27,6 +27,7 @@ namespace dataflow
 {
 namespace internal
 {
+class inbox;
 
 class DATAFLOW___EXPORT ref
 {
@@ -53,10 +54,26 @@ protected:
 
   void schedule_() const;
 
-  void set_metadata(std::shared_ptr<const metadata> p_metadata);
+  // Tells whether the changes are collected into a batch
+  bool is_batching_() const;
+
+  void set_metadata(std::shared_ptr<const metadata> p_metadata) const;
+
+  bool has_metadata() const;
+  const std::shared_ptr<const metadata>& get_metadata() const;
+
+  inbox& get_inbox_() const;
 
   void reset_(const ref& other);
 
+  // Tells apart the nodes taking the same id one after another
+  std::uint32_t node_generation_() const;
+
+  // Tells whether the node `id` of the given generation still exists, e.g.
+  // when a message posted to it from another thread is delivered
+  static bool is_alive_(node_id id, std::uint32_t generation);
+  static ref acquire_(node_id id);
+
 private:
   explicit ref(node_id id);
 
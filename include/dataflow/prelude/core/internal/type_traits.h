@@ -75,5 +75,54 @@ public:
 
 template <typename T> constexpr const bool is_callable<T>::value;
 
+/// Checks whether `calculate()` of a const `Policy` accepts the const values
+/// of types `Xs`.
+template <typename Policy, typename... Xs> struct has_const_calculate
+{
+private:
+  template <typename U>
+  static decltype(std::declval<const U&>().calculate(
+                    std::declval<const Xs&>()...),
+                  std::true_type())
+  test_(int);
+
+  template <typename> static std::false_type test_(...);
+
+public:
+  static constexpr const bool value = decltype(test_<Policy>(0))::value;
+};
+
+template <typename Policy, typename... Xs>
+constexpr const bool has_const_calculate<Policy, Xs...>::value;
+
+/// Checks whether values of type `T` carry a version stamp.
+///
+/// A type opts in by declaring the `version_type` member type and a
+/// `version()` member function returning a stamp of this type, which must
+/// change whenever the value changes. The engine compares the stamps instead
+/// of the values themselves to find out whether a node has changed, so large
+/// values are not compared deeply. A changed value is still copied into every
+/// node that takes it over, so a large versioned type should make its copies
+/// cheap, e.g. by sharing the contents. A `version()` member alone does not
+/// make a type versioned.
+///
+template <typename T> struct is_versioned
+{
+private:
+  template <typename U, typename Version = typename U::version_type>
+  static std17::conjunction<
+    std::is_convertible<decltype(std::declval<const U&>().version()),
+                        Version>,
+    is_equality_comparable<Version>>
+  test_(int);
+
+  template <typename> static std::false_type test_(...);
+
+public:
+  static constexpr const bool value = decltype(test_<T>(0))::value;
+};
+
+template <typename T> constexpr const bool is_versioned<T>::value;
+
 }
 }
@@ -0,0 +1,231 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#include <dataflow/engine_loop.h>
+#include <dataflow/tuple.h>
+
+#include "prelude/core/internal/engine.h"
+#include "prelude/core/internal/timer_wheel.h"
+
+#include <condition_variable>
+#include <mutex>
+
+namespace dataflow
+{
+class EngineLoop::impl final
+{
+public:
+  using tick_type = internal::timer_wheel::tick_type;
+
+  // Timers are measured in milliseconds since the loop was created
+  using tick_duration = std::chrono::milliseconds;
+
+public:
+  impl()
+  : start_(clock::now())
+  , wheel_()
+  , mutex_()
+  , wakeup_cv_()
+  , stopping_(false)
+  , woken_(false)
+  {
+  }
+
+  tick_type elapsed_ticks(clock::time_point t) const
+  {
+    if (t <= start_)
+      return 0;
+
+    return std::chrono::duration_cast<tick_duration>(t - start_).count();
+  }
+
+  // The first tick not earlier than `t`
+  tick_type deadline_tick(clock::time_point t) const
+  {
+    const auto ticks = elapsed_ticks(t);
+
+    return start_ + tick_duration(ticks) < t ? ticks + 1 : ticks;
+  }
+
+  tick_type period_ticks(clock::duration period) const
+  {
+    if (period <= clock::duration::zero())
+      return 0;
+
+    const auto ticks = std::chrono::duration_cast<tick_duration>(period);
+
+    return ticks < period ? ticks.count() + 1 : ticks.count();
+  }
+
+  clock::time_point time_point(tick_type tick) const
+  {
+    return start_ + tick_duration(tick);
+  }
+
+  void wake_up()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      woken_ = true;
+    }
+
+    wakeup_cv_.notify_one();
+  }
+
+  void stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      stopping_ = true;
+    }
+
+    wakeup_cv_.notify_one();
+  }
+
+  // Returns `false` if the loop is stopped
+  bool wait()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    const auto woken = [this]() { return stopping_ || woken_; };
+
+    const auto next = wheel_.next_expiration();
+
+    if (next == internal::timer_wheel::never)
+      wakeup_cv_.wait(lock, woken);
+    else
+      wakeup_cv_.wait_until(lock, time_point(next), woken);
+
+    woken_ = false;
+
+    if (stopping_)
+    {
+      stopping_ = false;
+      return false;
+    }
+
+    return true;
+  }
+
+  internal::timer_wheel& wheel()
+  {
+    return wheel_;
+  }
+
+private:
+  const clock::time_point start_;
+  internal::timer_wheel wheel_;
+  std::mutex mutex_;
+  std::condition_variable wakeup_cv_;
+  bool stopping_;
+  bool woken_;
+};
+
+EngineLoop::EngineLoop(engine_options options)
+: Engine(options)
+, p_impl_(new impl())
+{
+  internal::engine::instance().get_inbox().set_wakeup(
+    [p_impl = p_impl_.get()]() { p_impl->wake_up(); });
+}
+
+EngineLoop::~EngineLoop()
+{
+  internal::engine::instance().get_inbox().set_wakeup(nullptr);
+}
+
+void EngineLoop::run()
+{
+  do
+  {
+    run_once();
+  } while (p_impl_->wait());
+}
+
+void EngineLoop::run_once()
+{
+  Batch batch;
+
+  p_impl_->wheel().advance(p_impl_->elapsed_ticks(clock::now()));
+
+  batch.commit();
+}
+
+void EngineLoop::stop()
+{
+  p_impl_->stop();
+}
+
+EngineLoop::timer_id EngineLoop::start_timer(clock::duration delay,
+                                             std::function<void()> callback,
+                                             clock::duration period)
+{
+  return p_impl_->wheel().start(p_impl_->deadline_tick(clock::now() + delay),
+                                p_impl_->period_ticks(period),
+                                std::move(callback));
+}
+
+EngineLoop::timer_id
+EngineLoop::start_timer_at(clock::time_point deadline,
+                           std::function<void()> callback)
+{
+  return p_impl_->wheel().start(
+    p_impl_->deadline_tick(deadline), 0, std::move(callback));
+}
+
+bool EngineLoop::stop_timer(timer_id id)
+{
+  return p_impl_->wheel().stop(id);
+}
+
+ref<bool> EngineLoop::timeout_(const ref<integer>& interval_msec, dtime t0)
+{
+  const auto p_tick = std::make_shared<sig>(Signal());
+
+  struct policy
+  {
+    std::string label() const
+    {
+      return "timeout";
+    }
+
+    unit calculate(const int& msec)
+    {
+      p_loop->start_timer(
+        std::chrono::milliseconds(msec),
+        [p_tick = std::weak_ptr<sig>(this->p_tick)]() {
+          if (const auto ptr = p_tick.lock())
+          {
+            (*ptr)();
+          }
+        });
+
+      return {};
+    }
+
+    EngineLoop* p_loop;
+    const std::shared_ptr<sig> p_tick;
+  };
+
+  const auto timer = core::LiftPuller(policy{this, p_tick}, interval_msec(t0));
+
+  return Second(TupleC(timer, *p_tick));
+}
+}
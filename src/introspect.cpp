@@ -24,11 +24,15 @@
 #include <boost/iterator/filter_iterator.hpp>
 #include <boost/iterator/transform_iterator.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <fstream>
 #include <iomanip> // std::quoted
 #include <iostream>
 #include <memory>
 #include <regex>
 #include <sstream> // std::stringstream
+#include <stdexcept>
 #include <type_traits>
 
 namespace dataflow
@@ -156,8 +160,7 @@ introspect::out_edge_range
 introspect::out_edges(dependency_graph::vertex_descriptor v,
                       const dependency_graph& g)
 {
-  using base_iterator =
-    boost::graph_traits<internal::dependency_graph>::out_edge_iterator;
+  using base_iterator = internal::dependency_graph::out_edge_iterator;
 
   base_iterator from, to;
   std::tie(from, to) =
@@ -201,7 +204,7 @@ introspect::vertex_range introspect::vertices(const dependency_graph& g)
 
   using base_iterator = boost::filter_iterator<
     std::function<bool(internal::vertex_descriptor)>,
-    boost::graph_traits<internal::dependency_graph>::vertex_iterator>;
+    internal::dependency_graph::vertex_iterator>;
 
   using iterator_delegate =
     iterator_delegate<base_iterator, const dependency_graph::vertex_descriptor>;
@@ -303,7 +306,7 @@ introspect::dependency_graph::vertices_size_type introspect::num_updated_nodes()
 
 std::size_t introspect::memory_consumption()
 {
-  return internal::engine::allocator_type::allocated();
+  return internal::engine::memory_consumption();
 }
 
 // Vertex properties
@@ -370,23 +373,25 @@ int introspect::update_order(dependency_graph::vertex_descriptor u,
 introspect::vertex_range
 introspect::consumers(dependency_graph::vertex_descriptor v)
 {
+  using base_iterator = internal::dependency_graph::consumer_iterator;
+
   using iterator_delegate =
-    iterator_delegate<internal::consumers_list::const_iterator,
-                      const dependency_graph::vertex_descriptor>;
+    iterator_delegate<base_iterator, const dependency_graph::vertex_descriptor>;
 
-  iterator_delegate::transform_function fn =
-    [](const internal::consumers_list::const_iterator& it) {
-      return converter::convert(*it);
-    };
+  iterator_delegate::transform_function fn = [](const base_iterator& it) {
+    return converter::convert(*it);
+  };
+
+  internal::engine::instance().expose_node(converter::convert(v));
 
-  const auto& consumers =
-    internal::engine::instance().graph()[converter::convert(v)].consumers;
+  const auto vs =
+    consumers(converter::convert(v), internal::engine::instance().graph());
 
   return std::make_pair(
     dependency_graph::vertex_iterator(std::unique_ptr<iterator_delegate>(
-      new iterator_delegate(consumers.begin(), fn))),
+      new iterator_delegate(vs.begin(), fn))),
     dependency_graph::vertex_iterator(std::unique_ptr<iterator_delegate>(
-      new iterator_delegate(consumers.end(), fn))));
+      new iterator_delegate(vs.end(), fn))));
 }
 
 std::string introspect::label(dependency_graph::vertex_descriptor v)
@@ -414,6 +419,8 @@ std::string introspect::value(dependency_graph::vertex_descriptor v)
   if (v == dependency_graph::vertex_descriptor())
     return "";
 
+  internal::engine::instance().expose_node(converter::convert(v));
+
   return internal::engine::instance()
     .graph()[converter::convert(v)]
     .p_node->to_string();
@@ -530,4 +537,166 @@ void introspect::write_graphviz()
 {
   write_graphviz(std::cout);
 }
+
+std::vector<introspect::node_profile>
+introspect::hottest_nodes(std::size_t count)
+{
+  const auto records = internal::engine::instance().profile();
+
+  std::vector<node_profile> profiles;
+  profiles.reserve(records.size());
+
+  for (const auto& r : records)
+  {
+    profiles.push_back(
+      node_profile{r.first,
+                   static_cast<std::size_t>(r.second.updates_count),
+                   std::chrono::nanoseconds(r.second.total_update_ns),
+                   std::chrono::nanoseconds(r.second.max_update_ns),
+                   static_cast<std::size_t>(r.second.activations_count),
+                   static_cast<std::size_t>(r.second.deactivations_count)});
+  }
+
+  const auto hotter = [](const node_profile& a, const node_profile& b) {
+    return a.total_update_time != b.total_update_time
+             ? a.total_update_time > b.total_update_time
+             : a.label < b.label;
+  };
+
+  if (count < profiles.size())
+  {
+    std::partial_sort(
+      profiles.begin(), profiles.begin() + count, profiles.end(), hotter);
+    profiles.resize(count);
+  }
+  else
+  {
+    std::sort(profiles.begin(), profiles.end(), hotter);
+  }
+
+  return profiles;
+}
+
+void introspect::reset_profile()
+{
+  internal::engine::instance().reset_profile();
+}
+
+void introspect::write_profile(std::ostream& out, std::size_t count)
+{
+  assert(out);
+
+  out << std::left << std::setw(32) << "label" << std::right << std::setw(12)
+      << "updates" << std::setw(14) << "total, us" << std::setw(12)
+      << "max, us" << std::setw(12) << "activations" << "\n";
+
+  for (const auto& p : hottest_nodes(count))
+  {
+    out << std::left << std::setw(32) << p.label << std::right
+        << std::setw(12) << p.updates_count << std::setw(14)
+        << p.total_update_time.count() / 1000 << std::setw(12)
+        << p.max_update_time.count() / 1000 << std::setw(12)
+        << p.activations_count << "\n";
+  }
+}
+
+void introspect::start_tracing(std::size_t capacity)
+{
+  internal::engine::instance().start_tracing(capacity);
+}
+
+void introspect::stop_tracing()
+{
+  internal::engine::instance().stop_tracing();
+}
+
+void introspect::write_trace(std::ostream& out)
+{
+  assert(out);
+
+  internal::engine::instance().write_trace(out);
+}
+
+void introspect::write_trace(const std::string& file_name)
+{
+  std::ofstream out(file_name);
+
+  if (!out)
+    throw std::runtime_error("Can't open trace file '" + file_name + "'");
+
+  write_trace(out);
+}
+
+void introspect::set_pump_history_capacity(std::size_t capacity)
+{
+  internal::engine::instance().set_pump_history_capacity(capacity);
+}
+
+std::vector<introspect::pump_stats> introspect::pump_history()
+{
+  const auto history = internal::engine::instance().pump_history();
+
+  std::vector<pump_stats> result;
+  result.reserve(history.size());
+
+  for (const auto& s : history)
+  {
+    result.push_back(pump_stats{
+      s.tick,
+      s.rounds_count,
+      s.updated_nodes_count,
+      s.changed_nodes_count,
+      s.activations_count,
+      s.deactivations_count,
+      s.topological_moves_count,
+      s.allocations_count,
+      s.allocated_bytes,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(s.wall_time)});
+  }
+
+  return result;
+}
+
+introspect::pump_stats introspect::pump_history_percentile(double percentile)
+{
+  assert(percentile >= 0.0 && percentile <= 100.0);
+
+  const auto history = pump_history();
+
+  pump_stats result{};
+
+  if (history.empty())
+    return result;
+
+  // Nearest rank, 1-based
+  const auto rank = std::max<std::size_t>(
+    static_cast<std::size_t>(std::ceil(percentile / 100.0 * history.size())),
+    1);
+
+  const auto select = [&](auto field) {
+    std::vector<std::decay_t<decltype(history.front().*field)>> values;
+    values.reserve(history.size());
+
+    for (const auto& s : history)
+      values.push_back(s.*field);
+
+    std::nth_element(values.begin(), values.begin() + rank - 1, values.end());
+
+    result.*field = values[rank - 1];
+  };
+
+  result.tick = history.back().tick;
+
+  select(&pump_stats::rounds_count);
+  select(&pump_stats::updated_nodes_count);
+  select(&pump_stats::changed_nodes_count);
+  select(&pump_stats::activations_count);
+  select(&pump_stats::deactivations_count);
+  select(&pump_stats::topological_moves_count);
+  select(&pump_stats::allocations_count);
+  select(&pump_stats::allocated_bytes);
+  select(&pump_stats::wall_time);
+
+  return result;
+}
 } // dataflow
@@ -42,6 +42,28 @@ std::ostream& dataflow::operator<<(std::ostream& out, const unit&)
 
 namespace dataflow
 {
+Engine::Batch::Batch()
+: committed_(false)
+{
+  internal::engine::instance().begin_batch();
+}
+
+Engine::Batch::~Batch()
+{
+  // The updates are left to the next pump, which cannot throw from here
+  if (!committed_)
+    internal::engine::instance().end_batch(false);
+}
+
+void Engine::Batch::commit()
+{
+  DATAFLOW___CHECK_PRECONDITION(!committed_);
+
+  committed_ = true;
+
+  internal::engine::instance().end_batch();
+}
+
 Engine::Engine(engine_options options)
 {
   internal::engine::start(this, options);
@@ -52,6 +74,31 @@ Engine::~Engine()
   internal::engine::stop();
 }
 
+void Engine::deliver_posted()
+{
+  internal::engine::instance().deliver_posted();
+}
+
+void Engine::set_branch_retention(std::size_t pumps, std::size_t max_branches)
+{
+  internal::engine::instance().set_branch_retention(pumps, max_branches);
+}
+
+void Engine::set_pump_budget(std::chrono::microseconds budget)
+{
+  internal::engine::instance().set_pump_budget(budget);
+}
+
+bool Engine::resume_pump()
+{
+  return internal::engine::instance().resume_pump();
+}
+
+bool Engine::settled() const
+{
+  return internal::engine::instance().is_settled();
+}
+
 Engine* Engine::engine_()
 {
   return static_cast<Engine*>(internal::engine::data());
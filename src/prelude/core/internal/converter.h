@@ -31,7 +31,7 @@ namespace internal
 class converter final
 {
 private:
-  static_assert(sizeof(vertex_descriptor) == sizeof(node_id),
+  static_assert(sizeof(vertex_descriptor) <= sizeof(node_id),
                 "incompatible types");
 
   static_assert(std::is_trivially_copyable<node_id>::value,
@@ -43,12 +43,12 @@ private:
 public:
   static node_id convert(vertex_descriptor v)
   {
-    return reinterpret_cast<node_id>(v);
+    return static_cast<node_id>(v);
   }
 
   static vertex_descriptor convert(node_id id)
   {
-    return reinterpret_cast<vertex_descriptor>(id);
+    return static_cast<vertex_descriptor>(id);
   }
 };
 }
@@ -23,14 +23,34 @@
 
 #include <dst/allocator/utility.h>
 
+#include <boost/container_hash/hash.hpp>
+
+#include <algorithm>
 #include <cstdint> // std::intptr_t
+#include <iterator>
+#include <queue>
 #include <stack>
+#include <thread>
 
 namespace dataflow
 {
 namespace internal
 {
-engine* engine::gp_engine_ = nullptr;
+namespace
+{
+std::size_t
+shared_node_seed(const std::type_info& type, bool eager, bool concurrent)
+{
+  auto seed = type.hash_code();
+
+  boost::hash_combine(seed, eager);
+  boost::hash_combine(seed, concurrent);
+
+  return seed;
+}
+}
+
+thread_local engine* engine::gp_engine_ = nullptr;
 
 void engine::start(void* p_data, engine_options options)
 {
@@ -85,11 +105,15 @@ vertex_descriptor engine::add_node(node* p_node,
                                    std::size_t args_count,
                                    bool eager,
                                    bool conditional,
-                                   bool pump)
+                                   bool pump,
+                                   bool concurrent)
 {
   CHECK_ARGUMENT(!pump || eager); // pump => (implies) eager
   CHECK_PRECONDITION(p_node != nullptr);
 
+  if (eager)
+    settle_();
+
   const auto v = add_vertex(vertex(p_node), graph_);
 
   for (std::size_t i = 0; i < args_count; ++i)
@@ -100,6 +124,7 @@ vertex_descriptor engine::add_node(node* p_node,
   }
 
   graph_[v].conditional = conditional;
+  graph_[v].concurrent = concurrent;
 
   if (eager)
   {
@@ -133,7 +158,7 @@ vertex_descriptor engine::add_node(node* p_node,
     CHECK_CONDITION(eager);
     CHECK_CONDITION(order_.marked(graph_[v].position));
 
-    pumpa_.pump(graph_, order_, time_node_v_);
+    pump_();
   }
 
   return v;
@@ -154,6 +179,100 @@ vertex_descriptor engine::add_persistent_node(node* p_node)
   return v;
 }
 
+vertex_descriptor engine::find_shared_node(const std::type_info& type,
+                                           const node_id* p_args,
+                                           std::size_t args_count,
+                                           bool eager,
+                                           bool concurrent) const
+{
+  if ((options_ & engine_options::common_subexpression_elimination) ==
+      engine_options::nothing)
+    return vertex_descriptor();
+
+  auto hash = shared_node_seed(type, eager, concurrent);
+
+  for (std::size_t i = 0; i < args_count; ++i)
+    boost::hash_combine(hash, converter::convert(p_args[i]));
+
+  const auto range = shared_nodes_.equal_range(hash);
+
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    const auto v = it->second;
+
+    if (typeid(*graph_[v].p_node) != type || graph_[v].eager != eager ||
+        graph_[v].concurrent != concurrent ||
+        data_args_count_(v) != args_count)
+      continue;
+
+    std::size_t i = 0;
+
+    for (; i < args_count; ++i)
+    {
+      if (target(out_edge_at_(v, i), graph_) != converter::convert(p_args[i]))
+        break;
+    }
+
+    if (i == args_count)
+      return v;
+  }
+
+  return vertex_descriptor();
+}
+
+void engine::share_node(vertex_descriptor v)
+{
+  CHECK_PRECONDITION(!graph_[v].shared);
+  CHECK_PRECONDITION(!is_conditional_node(v));
+  CHECK_PRECONDITION(!is_persistent_node(v));
+
+  if ((options_ & engine_options::common_subexpression_elimination) ==
+      engine_options::nothing)
+    return;
+
+  shared_nodes_.emplace(shared_node_hash_(v), v);
+
+  graph_[v].shared = true;
+}
+
+bool engine::can_fold(const node_id* p_args, std::size_t args_count) const
+{
+  if ((options_ & engine_options::constant_folding) == engine_options::nothing)
+    return false;
+
+  for (std::size_t i = 0; i < args_count; ++i)
+  {
+    if (!is_persistent_node(converter::convert(p_args[i])))
+      return false;
+  }
+
+  return true;
+}
+
+void engine::track_changes(vertex_descriptor v)
+{
+  graph_[v].tracked = true;
+
+  pumpa_.unfuse(v);
+}
+
+void engine::expose_node(vertex_descriptor v)
+{
+  graph_[v].exposed = true;
+
+  pumpa_.unfuse(v);
+}
+
+std::uint64_t engine::last_change(vertex_descriptor v) const
+{
+  return pumpa_.last_change(v);
+}
+
+std::uint64_t engine::pumps_count() const
+{
+  return pumpa_.pumps_count();
+}
+
 void engine::add_data_edge(vertex_descriptor u, vertex_descriptor v)
 {
   CHECK_PRECONDITION(!is_active_node(u));
@@ -174,6 +293,14 @@ void engine::remove_data_edge(vertex_descriptor u, std::size_t idx)
   remove_edge(e, graph_);
 }
 
+void engine::schedule(vertex_descriptor v)
+{
+  CHECK_PRECONDITION(is_active_node(v));
+  CHECK_PRECONDITION(!is_pumping());
+
+  order_.mark(graph_[v].position);
+}
+
 void engine::schedule_and_pump(vertex_descriptor v)
 {
   CHECK_PRECONDITION(is_active_node(v));
@@ -181,7 +308,7 @@ void engine::schedule_and_pump(vertex_descriptor v)
 
   order_.mark(graph_[v].position);
 
-  pumpa_.pump(graph_, order_, time_node_v_);
+  pump_();
 }
 
 void engine::schedule_for_next_update(vertex_descriptor v)
@@ -197,6 +324,126 @@ bool engine::is_pumping() const
   return pumpa_.is_pumping();
 }
 
+void engine::begin_batch()
+{
+  CHECK_PRECONDITION(!is_pumping());
+
+  ++batch_depth_;
+}
+
+void engine::end_batch(bool pump)
+{
+  CHECK_PRECONDITION(is_batching());
+  CHECK_PRECONDITION(!is_pumping());
+
+  if (--batch_depth_ == 0 && pump &&
+      (order_.begin_marked() != order_.end_marked() || !inbox_.empty()))
+  {
+    pump_();
+  }
+}
+
+bool engine::is_batching() const
+{
+  return batch_depth_ != 0;
+}
+
+void engine::deliver_posted()
+{
+  CHECK_PRECONDITION(!is_pumping());
+
+  if (is_batching())
+    deliver_posted_();
+  else if (!inbox_.empty())
+    pump_();
+}
+
+void engine::set_pump_budget(std::chrono::microseconds budget)
+{
+  CHECK_ARGUMENT(budget >= std::chrono::microseconds::zero());
+
+  pump_budget_ = budget;
+}
+
+bool engine::resume_pump()
+{
+  CHECK_PRECONDITION(!is_pumping());
+
+  if (!pumpa_.is_interrupted())
+    return true;
+
+  if (!run_pumpa_(true, pump_deadline_()))
+    return false;
+
+  finish_pump_();
+
+  return true;
+}
+
+bool engine::is_settled() const
+{
+  return !pumpa_.is_interrupted();
+}
+
+std::vector<std::pair<std::string, profiler::record>> engine::profile() const
+{
+  CHECK_PRECONDITION((options_ & engine_options::profiling) !=
+                     engine_options::nothing);
+
+  return profiler_.collect(graph_);
+}
+
+void engine::reset_profile()
+{
+  profiler_.reset();
+}
+
+void engine::set_pump_history_capacity(std::size_t capacity)
+{
+  settle_();
+
+  pump_history_.reset(capacity);
+}
+
+std::vector<engine::pump_stats> engine::pump_history() const
+{
+  std::vector<pump_stats> history;
+  history.reserve(pump_history_.size());
+
+  for (std::size_t i = 0; i < pump_history_.size(); ++i)
+    history.push_back(pump_history_[i]);
+
+  return history;
+}
+
+void engine::start_tracing(std::size_t capacity)
+{
+  tracer_.start(capacity);
+}
+
+void engine::stop_tracing()
+{
+  tracer_.stop();
+}
+
+void engine::write_trace(std::ostream& out) const
+{
+  tracer_.write(out);
+}
+
+void engine::run_async(task_queue::task_type task)
+{
+  if (!p_task_queue_)
+  {
+    const auto workers_count =
+      std::max<std::size_t>(std::thread::hardware_concurrency(), 2);
+
+    p_task_queue_.reset(new task_queue(workers_count));
+  }
+
+  p_task_queue_->push(std::move(task));
+}
+
 void engine::set_metadata(const node* p_node,
                           std::shared_ptr<const metadata> p_metadata)
 {
@@ -204,6 +451,11 @@ void engine::set_metadata(const node* p_node,
   return pumpa_.set_metadata(p_node, p_metadata);
 }
 
+bool engine::has_metadata(const node* p_node) const
+{
+  return pumpa_.has_metadata(p_node);
+}
+
 const std::shared_ptr<const metadata>& engine::get_metadata(const node* p_node)
 {
   return pumpa_.get_metadata(p_node);
@@ -231,9 +483,22 @@ update_status engine::update_node_if_activator(vertex_descriptor v,
       const auto e_prev = out_edge_at_(w, 1 + old_value);
       const auto e_curr = out_edge_at_(w, 1 + new_value);
 
-      deactivate_subgraph_(e_prev);
+      // Branches given by functions of time have to be instantiated anew
+      if (branch_retention_pumps_ == 0 || is_eager_node(w))
+      {
+        deactivate_subgraph_(e_prev);
+
+        activate_subgraph_(e_curr);
+      }
+      else
+      {
+        // The previous branch stays active for a while, so that it is
+        // instantly available if the condition changes back
+        if (!unpark_branch_(e_curr))
+          activate_subgraph_(e_curr);
 
-      activate_subgraph_(e_curr);
+        park_branch_(e_prev);
+      }
 
       return update_status::updated;
     }
@@ -404,24 +669,51 @@ engine::update_node_recursion_activator(vertex_descriptor v, bool initialized)
 }
 
 engine::engine(void* p_data, engine_options options)
-: allocator_()
+: memory_counters_()
+, pool_(memory_counters_)
+, allocator_(memory_counters_,
+             (options & engine_options::pooled_allocation) !=
+                 engine_options::nothing
+               ? &pool_
+               : nullptr)
 , p_data_(p_data)
 , options_(options)
-, graph_()
-#ifdef DATAFLOW___EXPERIMENTAL_BUILD_WITH_BOOST_POOL_ALLOCATOR
-, order_()
-#else
-, order_(allocator_)
-#endif
-, pumpa_(allocator_, options)
+, graph_(allocator_)
+, order_(allocator_,
+         (options & engine_options::dense_scheduling) !=
+           engine_options::nothing)
+, profiler_()
+, tracer_()
+, pumpa_(memory_allocator<char>(memory_counters_),
+         options,
+         (options & engine_options::profiling) != engine_options::nothing
+           ? &profiler_
+           : nullptr,
+         tracer_)
 , ticks_()
 , time_node_v_()
+, batch_depth_(0)
+, inbox_()
+, shared_nodes_(allocator_.fallback())
+, pumps_count_(0)
+, branch_retention_pumps_(0)
+, max_parked_branches_(0)
+, parked_branches_(allocator_.fallback())
+, parked_branches_index_(allocator_.fallback())
+, pump_budget_(0)
+, activations_count_(0)
+, deactivations_count_(0)
+, topological_moves_count_(0)
+, pump_start_()
+, pump_history_(0, allocator_.fallback())
+, p_task_queue_()
 {
 }
 
 engine::~engine() noexcept
 {
   CHECK_PRECONDITION_NOEXCEPT(num_vertices(graph_) == 1);
+  CHECK_PRECONDITION_NOEXCEPT(batch_depth_ == 0);
 
   try
   {
@@ -495,13 +787,57 @@ topological_position engine::new_topological_pos_(topological_position position,
   return order_.insert(position, v);
 }
 
+std::size_t engine::data_args_count_(vertex_descriptor v) const
+{
+  const auto n = out_degree(v, graph_);
+
+  return is_active_node(v) ? n - 1 : n;
+}
+
+std::size_t engine::shared_node_hash_(vertex_descriptor v) const
+{
+  auto hash = shared_node_seed(
+    typeid(*graph_[v].p_node), graph_[v].eager, graph_[v].concurrent);
+
+  for (std::size_t i = 0; i < data_args_count_(v); ++i)
+    boost::hash_combine(hash, target(out_edge_at_(v, i), graph_));
+
+  return hash;
+}
+
+void engine::unshare_node_(vertex_descriptor v)
+{
+  CHECK_PRECONDITION(graph_[v].shared);
+
+  const auto range = shared_nodes_.equal_range(shared_node_hash_(v));
+
+  const auto it = std::find_if(
+    range.first, range.second, [v](const shared_nodes_map::value_type& p) {
+      return p.second == v;
+    });
+
+  CHECK_CONDITION(it != range.second);
+
+  shared_nodes_.erase(it);
+
+  graph_[v].shared = false;
+}
+
 void engine::delete_node_(vertex_descriptor v)
 {
   CHECK_PRECONDITION(!is_active_node(v));
   CHECK_PRECONDITION(graph_[v].p_node);
 
+  if (graph_[v].shared)
+    unshare_node_(v);
+
+  pumpa_.forget(v);
+
   const auto p_node = graph_[v].p_node;
 
+  if ((options_ & engine_options::profiling) != engine_options::nothing)
+    profiler_.forget(v, p_node->label());
+
   const auto info = p_node->mem_info();
 
   p_node->~node();
@@ -522,6 +858,11 @@ void engine::activate_vertex_(vertex_descriptor v,
 
   graph_[v].p_node->activate(converter::convert(v), ticks_);
 
+  ++activations_count_;
+
+  if ((options_ & engine_options::profiling) != engine_options::nothing)
+    profiler_.record_activation(v);
+
   graph_[v].position = pos;
 
   add_logical_edge_(v, w);
@@ -534,14 +875,37 @@ void engine::deactivate_vertex_partially_(vertex_descriptor v)
 {
   CHECK_PRECONDITION(is_active_node(v));
   CHECK_PRECONDITION(graph_[v].initialized);
-  CHECK_PRECONDITION(graph_[v].consumers.size() == 0);
+  CHECK_PRECONDITION(graph_[v].consumers.empty());
   CHECK_PRECONDITION(graph_[v].p_node != nullptr);
 
   remove_from_topological_list_(v);
 
+  pumpa_.unfuse(v);
+
   graph_[v].initialized = false;
+  graph_[v].parked = false;
+  graph_[v].stale = false;
+
+  ++deactivations_count_;
 
-  graph_[v].p_node->deactivate(converter::convert(v));
+  if ((options_ & engine_options::profiling) != engine_options::nothing)
+    profiler_.record_deactivation(v);
+
+  if (graph_[v].conditional && !parked_branches_.empty())
+    unpark_branches_(v);
+
+  if ((options_ & engine_options::retain_values) != engine_options::nothing)
+  {
+    const bool retain = graph_[v].p_node->retainable();
+
+    graph_[v].p_node->deactivate(converter::convert(v), retain);
+
+    pumpa_.retire(v, retain);
+  }
+  else
+  {
+    graph_[v].p_node->deactivate(converter::convert(v));
+  }
 
   CHECK_POSTCONDITION(!graph_[v].initialized);
   CHECK_POSTCONDITION(requires_activation(v));
@@ -564,6 +928,8 @@ void engine::move_to_topological_position_(vertex_descriptor v,
 
   const bool marked = order_.marked(graph_[v].position);
 
+  ++topological_moves_count_;
+
   remove_from_topological_list_(v);
 
   graph_[v].position = new_topological_pos_(graph_[w].position, v);
@@ -577,6 +943,8 @@ void engine::reset_activator_(vertex_descriptor v, vertex_descriptor w)
   CHECK_PRECONDITION(is_active_node(v));
   CHECK_PRECONDITION(is_logical_dependency(last_out_edge_(v)));
 
+  pumpa_.unfuse(v);
+
   remove_edge(last_out_edge_(v), graph_);
 
   add_logical_edge_(v, w);
@@ -586,11 +954,10 @@ void engine::activate_edge_(edge_descriptor e)
 {
   CHECK_PRECONDITION(!is_active_data_dependency(e));
 
-  const auto u = source(e, graph_);
-  const auto v = target(e, graph_);
+  // The consumers of a fused vertex must stay the same
+  pumpa_.unfuse(target(e, graph_));
 
-  graph_[v].consumers.push_front(u);
-  graph_[e] = graph_[v].consumers.cbegin();
+  link_consumer(e, graph_);
 
   CHECK_POSTCONDITION(is_active_data_dependency(e));
 }
@@ -600,9 +967,10 @@ void engine::deactivate_edge_(edge_descriptor e)
   CHECK_PRECONDITION(is_active_data_dependency(e));
   CHECK_PRECONDITION(is_active_node(source(e, graph_)));
 
-  graph_[target(e, graph_)].consumers.erase(graph_[e]);
+  pumpa_.unfuse(source(e, graph_));
+  pumpa_.unfuse(target(e, graph_));
 
-  graph_[e] = active_edge_ticket();
+  unlink_consumer(e, graph_);
 
   CHECK_POSTCONDITION(!is_active_data_dependency(e));
 }
@@ -622,6 +990,8 @@ void engine::activate_subgraph_(edge_descriptor e)
 
   std::stack<vertex_data> stack;
 
+  const auto start = tracer_.now();
+
   activate_edge_(e);
 
   stack.push({e, true, false, false});
@@ -679,6 +1049,10 @@ void engine::activate_subgraph_(edge_descriptor e)
 
         if (is_active_node(v))
         {
+          // A parked vertex gets a consumer outside of its branch
+          if (graph_[v].parked)
+            unpark_subgraph_(v);
+
           const auto b = implied_activator_(u, v);
 
           assert(is_active_node(b));
@@ -756,7 +1130,13 @@ void engine::activate_subgraph_(edge_descriptor e)
     }
   }
 
-  return;
+  if (tracer_.enabled())
+  {
+    const auto v = target(e, graph_);
+
+    tracer_.record(
+      tracer::event_type::activation, start, graph_[v].p_node->label(), v);
+  }
 }
 
 void engine::deactivate_subgraph_(edge_descriptor e)
@@ -765,6 +1145,8 @@ void engine::deactivate_subgraph_(edge_descriptor e)
 
   const auto v = target(e, graph_);
 
+  const auto start = tracer_.now();
+
   deactivate_edge_(e);
 
   std::stack<vd_handle> stack;
@@ -801,15 +1183,17 @@ void engine::deactivate_subgraph_(edge_descriptor e)
     {
       CHECK_CONDITION(!graph_[w].consumers.empty());
 
-      if (std::none_of(graph_[w].consumers.begin(),
-                       graph_[w].consumers.end(),
+      const auto w_consumers = consumers(w, graph_);
+
+      if (std::none_of(w_consumers.begin(),
+                       w_consumers.end(),
                        [this, w, a = activator_(w)](vertex_descriptor u) {
                          return a == implied_activator_(u, w);
                        }))
       {
         const auto b = *std::min_element(
-          graph_[w].consumers.begin(),
-          graph_[w].consumers.end(),
+          w_consumers.begin(),
+          w_consumers.end(),
           [this](vertex_descriptor u, vertex_descriptor v) {
             return order_.order(graph_[u].position, graph_[v].position);
           });
@@ -817,8 +1201,8 @@ void engine::deactivate_subgraph_(edge_descriptor e)
         move_to_topological_position_(w, b);
 
         const auto c = *std::min_element(
-          graph_[w].consumers.begin(),
-          graph_[w].consumers.end(),
+          w_consumers.begin(),
+          w_consumers.end(),
           [this, w](vertex_descriptor u, vertex_descriptor v) {
             const auto uim = implied_activator_(u, w);
             const auto vim = implied_activator_(v, w);
@@ -841,10 +1225,18 @@ void engine::deactivate_subgraph_(edge_descriptor e)
       }
     }
   }
+
+  if (tracer_.enabled())
+  {
+    tracer_.record(
+      tracer::event_type::deactivation, start, graph_[v].p_node->label(), v);
+  }
 }
 
 void engine::remove_subgraph_(vertex_descriptor v)
 {
+  settle_();
+
   std::stack<vertex_descriptor> stack;
 
   stack.push(v);
@@ -882,5 +1274,302 @@ void engine::remove_subgraph_(vertex_descriptor v)
     delete_node_(u);
   }
 }
+
+void engine::set_branch_retention(std::size_t pumps, std::size_t max_branches)
+{
+  CHECK_PRECONDITION(!is_pumping());
+
+  branch_retention_pumps_ = max_branches != 0 ? pumps : 0;
+  max_parked_branches_ = max_branches;
+
+  release_parked_branches_(0);
+}
+
+std::uint64_t engine::branch_key_(edge_descriptor e)
+{
+  return (static_cast<std::uint64_t>(e.u) << 32) | e.idx;
+}
+
+void engine::park_branch_(edge_descriptor e)
+{
+  CHECK_PRECONDITION(is_active_data_dependency(e));
+
+  if (parked_branches_.size() == max_parked_branches_)
+    release_parked_branches_(1);
+
+  parked_branches_.push_back({e, pumps_count_ + branch_retention_pumps_});
+  parked_branches_index_[branch_key_(e)] = std::prev(parked_branches_.end());
+
+  // A vertex is parked when all its consumers are parked, except for the
+  // conditional node consuming the root of the branch through `e`. Consumers
+  // follow their arguments in the topological order, so the candidates are
+  // examined from the last one, after all their consumers were decided.
+  const auto later = [this](vertex_descriptor a, vertex_descriptor b) {
+    return order_.order(graph_[a].position, graph_[b].position);
+  };
+
+  std::priority_queue<vertex_descriptor,
+                      std::vector<vertex_descriptor>,
+                      decltype(later)>
+    candidates(later);
+
+  const auto root = target(e, graph_);
+
+  candidates.push(root);
+
+  while (!candidates.empty())
+  {
+    const auto v = candidates.top();
+    candidates.pop();
+
+    if (graph_[v].eager || graph_[v].parked)
+      continue;
+
+    std::size_t allowed = v == root ? 1 : 0;
+    bool parked = true;
+
+    for (const auto u : consumers(v, graph_))
+    {
+      if (!graph_[u].parked && (u != e.u || allowed-- == 0))
+      {
+        parked = false;
+        break;
+      }
+    }
+
+    if (!parked)
+      continue;
+
+    graph_[v].parked = true;
+
+    // The last out-edge leads to the activator
+    for (auto es = out_edges(v, graph_); es.first != es.second - 1; ++es.first)
+    {
+      if (is_active_data_dependency(*es.first))
+        candidates.push(target(*es.first, graph_));
+    }
+  }
+}
+
+bool engine::unpark_branch_(edge_descriptor e)
+{
+  const auto it = parked_branches_index_.find(branch_key_(e));
+
+  if (it == parked_branches_index_.end())
+    return false;
+
+  parked_branches_.erase(it->second);
+  parked_branches_index_.erase(it);
+
+  unpark_subgraph_(target(e, graph_));
+
+  return true;
+}
+
+void engine::unpark_subgraph_(vertex_descriptor v)
+{
+  // Only the vertices that missed changes of their arguments are updated,
+  // the rest of the branch gets updated by the changes they propagate
+  std::stack<vertex_descriptor> stack;
+
+  stack.push(v);
+
+  while (!stack.empty())
+  {
+    const auto w = stack.top();
+    stack.pop();
+
+    if (!graph_[w].parked)
+      continue;
+
+    graph_[w].parked = false;
+
+    if (graph_[w].stale)
+    {
+      graph_[w].stale = false;
+      order_.mark(graph_[w].position);
+    }
+
+    for (auto es = out_edges(w, graph_); es.first != es.second - 1; ++es.first)
+    {
+      if (is_active_data_dependency(*es.first))
+        stack.push(target(*es.first, graph_));
+    }
+  }
+}
+
+void engine::unpark_branches_(vertex_descriptor v)
+{
+  // The branches are deactivated together with `v`
+  for (auto it = parked_branches_.begin(); it != parked_branches_.end();)
+  {
+    if (it->e.u == v)
+    {
+      parked_branches_index_.erase(branch_key_(it->e));
+      it = parked_branches_.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+void engine::release_parked_branches_(std::size_t count)
+{
+  // Branches are parked in the order of their expiration. At least `count` of
+  // them are released, the rest only if expired or if the retention is off.
+  auto last = parked_branches_.begin();
+
+  for (std::size_t i = 0;
+       last != parked_branches_.end() &&
+       (i < count || last->expires <= pumps_count_ ||
+        branch_retention_pumps_ == 0);
+       ++i, ++last)
+  {
+    parked_branches_index_.erase(branch_key_(last->e));
+  }
+
+  // Deactivation of a branch can deactivate other conditional nodes, which
+  // unpark their branches, so the released ones are taken out beforehand
+  std::vector<parked_branch> released(parked_branches_.begin(), last);
+
+  parked_branches_.erase(parked_branches_.begin(), last);
+
+  for (const auto& branch : released)
+  {
+    if (is_active_node(branch.e.u) && is_active_data_dependency(branch.e))
+      deactivate_subgraph_(branch.e);
+  }
+}
+
+void engine::deliver_posted_()
+{
+  if (inbox_.empty())
+    return;
+
+  // The posted updates are applied as a batch, so they cause a single pump
+  ++batch_depth_;
+
+  try
+  {
+    inbox_.deliver();
+  }
+  catch (...)
+  {
+    --batch_depth_;
+    throw;
+  }
+
+  --batch_depth_;
+}
+
+pumpa::time_point engine::pump_deadline_() const
+{
+  if (pump_budget_ == std::chrono::microseconds::zero())
+    return pumpa::time_point::max();
+
+  return pumpa::clock_type::now() + pump_budget_;
+}
+
+void engine::settle_()
+{
+  // Never the case while pumping
+  if (!pumpa_.is_interrupted())
+    return;
+
+  run_pumpa_(true, pumpa::time_point::max());
+
+  finish_pump_();
+}
+
+bool engine::run_pumpa_(bool resume, pumpa::time_point deadline)
+{
+  const auto run = [=]() {
+    return resume ? pumpa_.resume(graph_, order_, time_node_v_, deadline)
+                  : pumpa_.pump(graph_, order_, time_node_v_, deadline);
+  };
+
+  if (pump_history_.capacity() == 0)
+    return run();
+
+  const auto start = pumpa::clock_type::now();
+
+  const auto finished = run();
+
+  pump_start_.wall_time += pumpa::clock_type::now() - start;
+
+  return finished;
+}
+
+void engine::start_pump_stats_()
+{
+  pump_start_ = pump_stats{0,
+                           static_cast<std::size_t>(pumpa_.pumps_count()),
+                           0,
+                           0,
+                           activations_count_,
+                           deactivations_count_,
+                           topological_moves_count_,
+                           memory_counters_.allocations_count.load(
+                             std::memory_order_relaxed),
+                           memory_counters_.allocated_bytes_total.load(
+                             std::memory_order_relaxed),
+                           pumpa::clock_type::duration::zero()};
+}
+
+void engine::record_pump_stats_()
+{
+  CHECK_CONDITION(dynamic_cast<node_time*>(graph_[time_node_v_].p_node));
+
+  const auto p_node_time = static_cast<node_time*>(graph_[time_node_v_].p_node);
+
+  const pump_stats stats{
+    p_node_time->next_value(),
+    static_cast<std::size_t>(pumpa_.pumps_count()) - pump_start_.rounds_count,
+    pumpa_.pump_updated_nodes_count(),
+    pumpa_.pump_changed_nodes_count(),
+    activations_count_ - pump_start_.activations_count,
+    deactivations_count_ - pump_start_.deactivations_count,
+    topological_moves_count_ - pump_start_.topological_moves_count,
+    memory_counters_.allocations_count.load(std::memory_order_relaxed) -
+      pump_start_.allocations_count,
+    memory_counters_.allocated_bytes_total.load(std::memory_order_relaxed) -
+      pump_start_.allocated_bytes,
+    pump_start_.wall_time};
+
+  pump_history_.push_back(stats);
+}
+
+void engine::finish_pump_()
+{
+  if (!parked_branches_.empty())
+    release_parked_branches_(0);
+
+  if (pump_history_.capacity() != 0)
+    record_pump_stats_();
+}
+
+void engine::pump_()
+{
+  deliver_posted_();
+
+  // The changes made since the interruption join the interrupted pump
+  if (pumpa_.is_interrupted())
+  {
+    if (run_pumpa_(true, pump_deadline_()))
+      finish_pump_();
+  }
+  else if (order_.begin_marked() != order_.end_marked())
+  {
+    ++pumps_count_;
+
+    if (pump_history_.capacity() != 0)
+      start_pump_stats_();
+
+    if (run_pumpa_(false, pump_deadline_()))
+      finish_pump_();
+  }
+}
 } // internal
 } // dataflow
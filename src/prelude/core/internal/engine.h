@@ -24,10 +24,20 @@
 #include "converter.h"
 #include "discrete_time.h"
 #include "graph.h"
+#include "profiler.h"
 #include "pumpa.h"
+#include "ring_buffer.h"
+#include "task_queue.h"
+#include "tracer.h"
 
 #include <dataflow/prelude/core/engine_options.h>
+#include <dataflow/prelude/core/internal/inbox.h>
 
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <typeinfo>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -38,7 +48,7 @@ namespace internal
 class engine final
 {
 public:
-  using allocator_type = memory_allocator<char>;
+  using allocator_type = pool_allocator<char>;
 
 public:
   allocator_type get_allocator() const;
@@ -51,6 +61,8 @@ public:
 
   const node* get_node(vertex_descriptor v) const;
 
+  inbox& get_inbox();
+
 public:
   engine(const engine&) = delete;
   engine& operator=(const engine&) = delete;
@@ -64,11 +76,16 @@ public:
 
   static void* data();
 
+  // Memory allocated by the engine of the calling thread
+  static std::size_t memory_consumption();
+
   bool is_logical_dependency(edge_descriptor e) const;
   bool is_primary_data_dependency(edge_descriptor e) const;
   bool is_secondary_data_dependency(edge_descriptor e) const;
   bool is_active_data_dependency(edge_descriptor e) const;
 
+  bool has_node(vertex_descriptor v) const;
+  std::uint32_t node_generation(vertex_descriptor v) const;
   bool is_active_node(vertex_descriptor v) const;
   bool is_conditional_node(vertex_descriptor v) const;
   bool is_eager_node(vertex_descriptor v) const;
@@ -89,22 +106,94 @@ public:
                              std::size_t args_count,
                              bool eager,
                              bool conditional = false,
-                             bool pump = false);
+                             bool pump = false,
+                             bool concurrent = false);
 
   vertex_descriptor add_persistent_node(node* p_node);
 
+  vertex_descriptor find_shared_node(const std::type_info& type,
+                                     const node_id* p_args,
+                                     std::size_t args_count,
+                                     bool eager,
+                                     bool concurrent) const;
+
+  void share_node(vertex_descriptor v);
+
+  bool can_fold(const node_id* p_args, std::size_t args_count) const;
+
+  void track_changes(vertex_descriptor v);
+
+  // Keeps `v` out of the fused chains (see `engine_options::chain_fusion`)
+  void expose_node(vertex_descriptor v);
+
+  std::uint64_t last_change(vertex_descriptor v) const;
+
+  std::uint64_t pumps_count() const;
+
   void add_data_edge(vertex_descriptor u, vertex_descriptor v);
 
   void remove_data_edge(vertex_descriptor u, std::size_t idx);
 
+  void schedule(vertex_descriptor v);
+
   void schedule_and_pump(vertex_descriptor v);
 
   void schedule_for_next_update(vertex_descriptor v);
 
   bool is_pumping() const;
 
+  void begin_batch();
+  // The updates of a batch ended without a pump are left to the next pump
+  void end_batch(bool pump = true);
+
+  bool is_batching() const;
+
+  void deliver_posted();
+
+  // Runs `task` on a background worker thread. The task must not throw.
+  void run_async(task_queue::task_type task);
+
+  void set_branch_retention(std::size_t pumps, std::size_t max_branches);
+
+  void set_pump_budget(std::chrono::microseconds budget);
+
+  // Continues the interrupted pump. Returns `true` if the pump is complete.
+  bool resume_pump();
+
+  bool is_settled() const;
+
+  std::vector<std::pair<std::string, profiler::record>> profile() const;
+
+  void reset_profile();
+
+  // Statistics of a pump over all its rounds
+  struct pump_stats
+  {
+    std::size_t tick;
+    std::size_t rounds_count;
+    std::size_t updated_nodes_count;
+    std::size_t changed_nodes_count;
+    std::size_t activations_count;
+    std::size_t deactivations_count;
+    std::size_t topological_moves_count;
+    std::size_t allocations_count;
+    std::size_t allocated_bytes;
+    pumpa::clock_type::duration wall_time;
+  };
+
+  // Keeps the statistics of the latest `capacity` pumps
+  void set_pump_history_capacity(std::size_t capacity);
+
+  // From the oldest to the latest pump
+  std::vector<pump_stats> pump_history() const;
+
+  void start_tracing(std::size_t capacity);
+  void stop_tracing();
+  void write_trace(std::ostream& out) const;
+
   void set_metadata(const node* p_node,
                     std::shared_ptr<const metadata> p_metadata);
+  bool has_metadata(const node* p_node) const;
   const std::shared_ptr<const metadata>& get_metadata(const node* p_node);
 
   update_status update_node_if_activator(vertex_descriptor v,
@@ -149,6 +238,12 @@ private:
   topological_position new_topological_pos_(topological_position position,
                                             vertex_descriptor v);
 
+  std::size_t data_args_count_(vertex_descriptor v) const;
+
+  std::size_t shared_node_hash_(vertex_descriptor v) const;
+
+  void unshare_node_(vertex_descriptor v);
+
   void delete_node_(vertex_descriptor v);
 
   void activate_vertex_(vertex_descriptor v,
@@ -173,18 +268,95 @@ private:
 
   void remove_subgraph_(vertex_descriptor v);
 
+  static std::uint64_t branch_key_(edge_descriptor e);
+
+  // Stops updating the vertices reachable only through `e`
+  void park_branch_(edge_descriptor e);
+  // Resumes updating the branch parked at `e` and brings it up to date
+  bool unpark_branch_(edge_descriptor e);
+  void unpark_subgraph_(vertex_descriptor v);
+  void unpark_branches_(vertex_descriptor v);
+  void release_parked_branches_(std::size_t count);
+
+  void deliver_posted_();
+
+  pumpa::time_point pump_deadline_() const;
+
+  // Completes the interrupted pump before the active graph is changed from
+  // outside of the pump
+  void settle_();
+
+  // Runs or resumes the pump, measuring its time if the history is kept
+  bool run_pumpa_(bool resume, pumpa::time_point deadline);
+
+  void start_pump_stats_();
+
+  void record_pump_stats_();
+
+  void finish_pump_();
+
+  void pump_();
+
+private:
+  using shared_nodes_map = std::unordered_multimap<
+    std::size_t,
+    vertex_descriptor,
+    std::hash<std::size_t>,
+    std::equal_to<std::size_t>,
+    memory_allocator<std::pair<const std::size_t, vertex_descriptor>>>;
+
+  // A branch of a conditional node kept active after the condition changed
+  struct parked_branch
+  {
+    edge_descriptor e;
+    std::size_t expires;
+  };
+
+  // Parked branches in the order of their expiration, indexed by their edges
+  using parked_branches_list =
+    std::list<parked_branch, memory_allocator<parked_branch>>;
+
+  using parked_branches_map = std::unordered_map<
+    std::uint64_t,
+    parked_branches_list::iterator,
+    std::hash<std::uint64_t>,
+    std::equal_to<std::uint64_t>,
+    memory_allocator<
+      std::pair<const std::uint64_t, parked_branches_list::iterator>>>;
+
 private:
+  memory_counters memory_counters_;
+  slab_pool pool_;
   allocator_type allocator_;
   void* p_data_;
   const engine_options options_;
   dependency_graph graph_;
   topological_list order_;
+  profiler profiler_;
+  tracer tracer_;
   pumpa pumpa_;
   discrete_time ticks_;
   vertex_descriptor time_node_v_;
+  std::size_t batch_depth_;
+  inbox inbox_;
+  shared_nodes_map shared_nodes_;
+  std::size_t pumps_count_;
+  std::size_t branch_retention_pumps_;
+  std::size_t max_parked_branches_;
+  parked_branches_list parked_branches_;
+  parked_branches_map parked_branches_index_;
+  std::chrono::microseconds pump_budget_;
+  std::size_t activations_count_;
+  std::size_t deactivations_count_;
+  std::size_t topological_moves_count_;
+  // Counters at the start of the current pump and its time so far
+  pump_stats pump_start_;
+  ring_buffer<pump_stats, memory_allocator<pump_stats>> pump_history_;
+  // Destroyed before `inbox_`, since the tasks post their results there
+  std::unique_ptr<task_queue> p_task_queue_;
 
 private:
-  static engine* gp_engine_;
+  static thread_local engine* gp_engine_;
 };
 } // internal
 } // dataflow
@@ -31,6 +31,11 @@ inline engine::allocator_type engine::get_allocator() const
   return allocator_;
 }
 
+inline inbox& engine::get_inbox()
+{
+  return inbox_;
+}
+
 inline const dependency_graph& engine::graph() const
 {
   return graph_;
@@ -66,6 +71,15 @@ inline void* engine::data()
   return nullptr;
 }
 
+inline std::size_t engine::memory_consumption()
+{
+  if (gp_engine_ != nullptr)
+    return gp_engine_->memory_counters_.allocated_bytes.load(
+      std::memory_order_relaxed);
+
+  return 0;
+}
+
 inline bool engine::is_logical_dependency(edge_descriptor e) const
 {
   CHECK_PRECONDITION(e != edge_descriptor());
@@ -105,6 +119,16 @@ inline bool engine::is_active_data_dependency(edge_descriptor e) const
   return internal::is_active_data_dependency(e, graph_);
 }
 
+inline bool engine::has_node(vertex_descriptor v) const
+{
+  return contains_vertex(v, graph_);
+}
+
+inline std::uint32_t engine::node_generation(vertex_descriptor v) const
+{
+  return generation(v, graph_);
+}
+
 inline bool engine::is_active_node(vertex_descriptor v) const
 {
   return internal::is_active_node(v, graph_);
@@ -187,7 +211,7 @@ inline vertex_descriptor engine::main_consumer_(vertex_descriptor v) const
   CHECK_PRECONDITION(is_active_node(v));
   CHECK_PRECONDITION(!graph_[v].consumers.empty());
 
-  const auto u = graph_[v].consumers.back();
+  const auto u = earliest_consumer(v, graph_);
 
   CHECK_POSTCONDITION(is_conditional_node(u));
 
@@ -0,0 +1,267 @@
+
+//  Copyright (c) 2014 - 2020 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#include "graph.h"
+
+namespace dataflow
+{
+namespace internal
+{
+dependency_graph::dependency_graph(const pool_allocator<char>& allocator)
+: edges_allocator_(allocator)
+, chunks_(allocator.fallback())
+, live_(1, false, allocator.fallback())
+, generations_(1, 0, allocator.fallback())
+, free_list_()
+, size_(1)
+, num_vertices_()
+{
+}
+
+dependency_graph::~dependency_graph()
+{
+  for (vertex_descriptor v = 1; v < size_; ++v)
+  {
+    if (live_[v])
+      stored_(v).~stored_vertex();
+  }
+
+  memory_allocator<slot> allocator(chunks_.get_allocator());
+
+  for (const auto p_chunk : chunks_)
+    std::allocator_traits<memory_allocator<slot>>::deallocate(
+      allocator, p_chunk, chunk_size);
+}
+
+vertex_descriptor add_vertex(vertex properties, dependency_graph& g)
+{
+  const auto v = g.allocate_slot_();
+
+  new (&g.chunks_[v >> dependency_graph::chunk_bits]
+                 [v & (dependency_graph::chunk_size - 1)])
+    dependency_graph::stored_vertex{
+      properties,
+      dependency_graph::out_edge_list(g.edges_allocator_),
+      dependency_graph::arg_list(g.edges_allocator_)};
+
+  g.live_[v] = true;
+
+  ++g.num_vertices_;
+
+  return v;
+}
+
+void remove_vertex(vertex_descriptor v, dependency_graph& g)
+{
+  CHECK_PRECONDITION(g.is_valid_(v));
+
+  g.stored_(v).~stored_vertex();
+
+  g.live_[v] = false;
+  ++g.generations_[v];
+
+  // The slot of the removed vertex keeps the index of the next free slot
+  new (&g.chunks_[v >> dependency_graph::chunk_bits]
+                 [v & (dependency_graph::chunk_size - 1)])
+    vertex_descriptor(g.free_list_);
+
+  g.free_list_ = v;
+
+  --g.num_vertices_;
+}
+
+std::pair<edge_descriptor, bool>
+add_edge(vertex_descriptor u, vertex_descriptor v, dependency_graph& g)
+{
+  CHECK_PRECONDITION(g.is_valid_(v));
+
+  auto& out_edges = g.stored_(u).out_edges;
+
+  CHECK_CONDITION(out_edges.size() <
+                  std::numeric_limits<std::uint32_t>::max());
+
+  out_edges.push_back({v, edge_descriptor(), edge_descriptor()});
+
+  return std::make_pair(
+    edge_descriptor(u, static_cast<std::uint32_t>(out_edges.size() - 1)),
+    true);
+}
+
+void remove_edge(const edge_descriptor& e, dependency_graph& g)
+{
+  CHECK_PRECONDITION(!is_linked_consumer(e, g));
+
+  auto& out_edges = g.stored_(e.u).out_edges;
+
+  CHECK_PRECONDITION(e.idx < out_edges.size());
+
+  // The edges following the removed one are going to be shifted
+  const auto shifted = [&e](edge_descriptor f) {
+    return f.u == e.u && f.idx > e.idx ? edge_descriptor(f.u, f.idx - 1) : f;
+  };
+
+  // First, the links to the shifted edges from the other edges and from the
+  // consumers lists are updated. The links between the shifted edges (e.g.
+  // ones sharing a target) still use the current indices, so that they can be
+  // followed here, and are updated afterwards.
+  for (auto idx = e.idx + 1; idx < out_edges.size(); ++idx)
+  {
+    const auto old_e = edge_descriptor(e.u, idx);
+    const auto new_e = shifted(old_e);
+
+    const auto& record = out_edges[idx];
+
+    auto& consumers = g[record.target].consumers;
+
+    if (record.prev_consumer != edge_descriptor())
+    {
+      if (shifted(record.prev_consumer) == record.prev_consumer)
+        g.record_(record.prev_consumer).next_consumer = new_e;
+    }
+    else if (consumers.first == old_e)
+    {
+      consumers.first = new_e;
+    }
+    else
+    {
+      continue;
+    }
+
+    if (record.next_consumer != edge_descriptor())
+    {
+      if (shifted(record.next_consumer) == record.next_consumer)
+        g.record_(record.next_consumer).prev_consumer = new_e;
+    }
+    else
+    {
+      consumers.last = new_e;
+    }
+  }
+
+  for (auto idx = e.idx + 1; idx < out_edges.size(); ++idx)
+  {
+    auto& record = out_edges[idx];
+
+    record.prev_consumer = shifted(record.prev_consumer);
+    record.next_consumer = shifted(record.next_consumer);
+  }
+
+  out_edges.erase(out_edges.begin() + e.idx);
+}
+
+void link_consumer(const edge_descriptor& e, dependency_graph& g)
+{
+  CHECK_PRECONDITION(!is_linked_consumer(e, g));
+
+  auto& record = g.record_(e);
+  auto& consumers = g[record.target].consumers;
+
+  record.prev_consumer = edge_descriptor();
+  record.next_consumer = consumers.first;
+
+  if (consumers.first != edge_descriptor())
+    g.record_(consumers.first).prev_consumer = e;
+  else
+    consumers.last = e;
+
+  consumers.first = e;
+
+  auto& args = g.stored_(e.u).args;
+
+  args.insert(args.begin() + g.arg_position_(e), g[record.target].p_node);
+}
+
+void unlink_consumer(const edge_descriptor& e, dependency_graph& g)
+{
+  CHECK_PRECONDITION(is_linked_consumer(e, g));
+
+  auto& record = g.record_(e);
+  auto& consumers = g[record.target].consumers;
+
+  if (record.prev_consumer != edge_descriptor())
+    g.record_(record.prev_consumer).next_consumer = record.next_consumer;
+  else
+    consumers.first = record.next_consumer;
+
+  if (record.next_consumer != edge_descriptor())
+    g.record_(record.next_consumer).prev_consumer = record.prev_consumer;
+  else
+    consumers.last = record.prev_consumer;
+
+  record.prev_consumer = edge_descriptor();
+  record.next_consumer = edge_descriptor();
+
+  auto& args = g.stored_(e.u).args;
+
+  args.erase(args.begin() + g.arg_position_(e));
+}
+
+std::pair<dependency_graph::vertex_iterator, dependency_graph::vertex_iterator>
+vertices(const dependency_graph& g)
+{
+  using vertex_iterator = dependency_graph::vertex_iterator;
+
+  auto first = vertex_iterator(&g, 0);
+
+  ++first;
+
+  return std::make_pair(first, vertex_iterator(&g, g.size_));
+}
+
+vertex_descriptor dependency_graph::allocate_slot_()
+{
+  if (free_list_ != vertex_descriptor())
+  {
+    const auto v = free_list_;
+
+    free_list_ = reinterpret_cast<const vertex_descriptor&>(
+      chunks_[v >> chunk_bits][v & (chunk_size - 1)]);
+
+    return v;
+  }
+
+  CHECK_CONDITION(size_ < std::numeric_limits<graph_index>::max());
+
+  if ((size_ >> chunk_bits) == chunks_.size())
+  {
+    memory_allocator<slot> allocator(chunks_.get_allocator());
+
+    chunks_.push_back(std::allocator_traits<memory_allocator<slot>>::allocate(
+      allocator, chunk_size));
+  }
+
+  live_.push_back(false);
+  generations_.push_back(0);
+
+  return size_++;
+}
+
+std::size_t dependency_graph::arg_position_(const edge_descriptor& e) const
+{
+  std::size_t position = 0;
+
+  for (std::uint32_t idx = 0; idx < e.idx; ++idx)
+  {
+    if (is_linked_consumer(edge_descriptor(e.u, idx), *this))
+      ++position;
+  }
+
+  return position;
+}
+} // internal
+} // dataflow
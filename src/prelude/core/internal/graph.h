@@ -19,148 +19,101 @@
 #pragma once
 
 #include "config.h"
+#include "slab_pool.h"
+#include "topological_list.h"
 
 #include <dataflow/prelude/core/internal/node.h>
 
-#include <dst/allocator/global_counter_allocator.h>
-#include <dst/binary_tree/list.h>
-#include <dst/binary_tree/mixin/avl.h>
-#include <dst/binary_tree/mixin/marking.h>
-#include <dst/binary_tree/mixin/ordering.h>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/range/iterator_range.hpp>
 
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/graph_traits.hpp>
-
-// #define DATAFLOW___EXPERIMENTAL_BUILD_WITH_BOOST_POOL_ALLOCATOR
-#ifdef DATAFLOW___EXPERIMENTAL_BUILD_WITH_BOOST_POOL_ALLOCATOR
-#define BOOST_POOL_NO_MT       // disable multi-threading
-#define BOOST_THREAD_MUTEX_HPP // disable <boost/thread/mutex.hpp> header
-#include <boost/pool/pool_alloc.hpp>
-#endif
+// #define DATAFLOW___BUILD_WITH_64BIT_GRAPH_INDICES
 
 #include <cstddef>
+#include <cstdint>
 #include <limits>
-#include <list>
 #include <type_traits>
-
-#ifndef NDEBUG
-#include <unordered_set>
-#endif
+#include <utility>
+#include <vector>
 
 namespace dataflow
 {
 namespace internal
 {
-template <typename Allocator> struct out_edge_listS
-{
-};
-
-template <typename Allocator> struct vertex_listS
-{
-};
-} // internal
-} // dataflow
-
-namespace boost
-{
-template <typename Allocator, typename T>
-struct container_gen<dataflow::internal::out_edge_listS<Allocator>, T>
-{
-  using type = std::vector<
-    T,
-    typename std::allocator_traits<Allocator>::template rebind_alloc<T>>;
-};
-
-template <typename Allocator>
-struct parallel_edge_traits<dataflow::internal::out_edge_listS<Allocator>>
-: public parallel_edge_traits<boost::vecS>
-{
-};
-
-template <typename Allocator, typename T>
-struct container_gen<dataflow::internal::vertex_listS<Allocator>, T>
-{
-  using type = std::list<
-    T,
-    typename std::allocator_traits<Allocator>::template rebind_alloc<T>>;
-};
-} // boost
-
-namespace dataflow
-{
-namespace internal
-{
-using vertex_descriptor = void*;
-
-template <typename T> using memory_allocator = dst::global_counter_allocator<T>;
-
-#ifdef DATAFLOW___EXPERIMENTAL_BUILD_WITH_BOOST_POOL_ALLOCATOR
-template <typename T>
-using list_element_allocator = dst::global_counter_allocator<
-  T,
-  boost::fast_pool_allocator<T,
-                             boost::default_user_allocator_new_delete,
-                             boost::details::pool::null_mutex,
-                             1024 * 1024>>;
+/// Index of a vertex of the dependency graph.
+///
+/// `0` is reserved for the null vertex. 32-bit indices limit the graph to
+/// about 4G vertices. Define `DATAFLOW___BUILD_WITH_64BIT_GRAPH_INDICES` to
+/// lift this limit.
+///
+#ifdef DATAFLOW___BUILD_WITH_64BIT_GRAPH_INDICES
+using graph_index = std::uint64_t;
 #else
-template <typename T> using list_element_allocator = memory_allocator<T>;
+using graph_index = std::uint32_t;
 #endif
 
+using vertex_descriptor = graph_index;
+
 using topological_list =
-  dst::binary_tree::list<vertex_descriptor,
-                         list_element_allocator<vertex_descriptor>,
-                         dst::binary_tree::Marking<>,
-                         dst::binary_tree::AVL,
-                         dst::binary_tree::Ordering>;
+  labeled_list<vertex_descriptor, pool_allocator<vertex_descriptor>>;
 
 using topological_position = topological_list::const_iterator;
 
-using consumers_list =
-  std::list<vertex_descriptor, memory_allocator<vertex_descriptor>>;
-
-#if defined(_MSC_VER) && !defined(NDEBUG)
-class active_edge_ticket
+struct edge_descriptor final
 {
-public:
-  active_edge_ticket()
-  : engaged_{false}
+  edge_descriptor()
+  : u()
+  , idx()
   {
   }
 
-  active_edge_ticket(const consumers_list::const_iterator& ticket)
-  : engaged_{true}
-  , ticket_{ticket}
+  edge_descriptor(vertex_descriptor u, std::uint32_t idx)
+  : u(u)
+  , idx(idx)
   {
   }
 
-  operator const consumers_list::const_iterator&() const
+  bool operator==(const edge_descriptor& other) const
   {
-    return ticket_;
+    return u == other.u && idx == other.idx;
   }
 
-  bool operator==(const active_edge_ticket& other) const
+  bool operator!=(const edge_descriptor& other) const
   {
-    return (engaged_ == other.engaged_) &&
-           (!engaged_ || ticket_ == other.ticket_);
+    return !(*this == other);
   }
 
-  bool operator!=(const active_edge_ticket& other) const
+  vertex_descriptor u;
+  std::uint32_t idx;
+};
+
+/// Consumers of a vertex.
+///
+/// The list is threaded through the records of the active edges pointing to
+/// the vertex, so it refers only to the edges at its ends. The first edge is
+/// the most recently activated one.
+///
+struct consumers_list final
+{
+  consumers_list()
+  : first()
+  , last()
   {
-    return !(*this == other);
   }
 
-private:
-  bool engaged_;
-  consumers_list::const_iterator ticket_;
+  bool empty() const
+  {
+    return first == edge_descriptor();
+  }
+
+  edge_descriptor first;
+  edge_descriptor last;
 };
-#else
-using active_edge_ticket = consumers_list::const_iterator;
-#endif
 
 class vertex final
 {
 private:
-  using uint = std::size_t;
+  using uint = std::uint32_t;
 
 public:
   vertex(node* p_node)
@@ -170,17 +123,23 @@ public:
   , straight(false)
   , initialized(false)
   , hidden(false)
+  , concurrent(false)
+  , shared(false)
+  , tracked(false)
+  , parked(false)
+  , stale(false)
+  , exposed(false)
   , ref_count_(0)
   , position()
   , p_node(p_node)
   {
     assert(p_node);
 
-    const auto expected_size = sizeof(uint) +          // Flags
-                               sizeof(uint) +          // Reference counter
-                               sizeof(void*) +         // Topological position
-                               sizeof(void*) +         // Node pointer
-                               sizeof(consumers_list); // Consumers list
+    const auto expected_size = sizeof(uint) +           // Flags
+                               sizeof(uint) +           // Reference counter
+                               sizeof(void*) +          // Topological position
+                               sizeof(void*) +          // Node pointer
+                               sizeof(consumers_list);  // Consumers list
 
     static_assert(sizeof(vertex) == expected_size,
                   "Vertex size must be kept small");
@@ -210,6 +169,12 @@ public:
   const uint straight : 1; // TODO: not used?
   uint initialized : 1;
   const uint hidden : 1; // TODO: not used?
+  uint concurrent : 1;
+  uint shared : 1;
+  uint tracked : 1;
+  uint parked : 1;
+  uint stale : 1;
+  uint exposed : 1;
 
 private:
   uint ref_count_;
@@ -220,85 +185,371 @@ public:
   consumers_list consumers;
 };
 
-using dependency_graph_base =
-  boost::adjacency_list<out_edge_listS<memory_allocator<void>>,
-                        vertex_listS<memory_allocator<void>>,
-                        boost::directedS,
-                        vertex,
-                        active_edge_ticket,
-                        boost::no_property>;
-
-// TODO: reimplement `dependency_graph` class to be able to identify invalid
-//       vertices in constant time
-class dependency_graph : public dependency_graph_base
+/// Directed graph with the vertices stored in an arena.
+///
+/// Vertices are placed in fixed-size chunks, so they never move in memory,
+/// and are identified by compact indices. Slots of removed vertices are reused
+/// by the subsequently added ones. Out-edges are kept next to the vertex
+/// properties.
+///
+class dependency_graph final
 {
+private:
+  struct edge_record
+  {
+    vertex_descriptor target;
+    edge_descriptor prev_consumer;
+    edge_descriptor next_consumer;
+  };
+
+  using out_edge_list = std::vector<edge_record, pool_allocator<edge_record>>;
+  using arg_list = std::vector<const node*, pool_allocator<const node*>>;
+
+  struct stored_vertex
+  {
+    vertex properties;
+    out_edge_list out_edges;
+    // Nodes of the targets of the linked out-edges, in the order of the edges
+    arg_list args;
+  };
+
+  using slot = typename std::aligned_storage<sizeof(stored_vertex),
+                                             alignof(stored_vertex)>::type;
+
+  static constexpr std::size_t chunk_bits = 10;
+  static constexpr std::size_t chunk_size = std::size_t(1) << chunk_bits;
+
 public:
-  vertex& operator[](const vertex_descriptor& v)
+  using degree_size_type = std::size_t;
+  using vertices_size_type = std::size_t;
+
+  class out_edge_iterator final
+  : public boost::iterator_facade<out_edge_iterator,
+                                  edge_descriptor,
+                                  boost::random_access_traversal_tag,
+                                  edge_descriptor>
+  {
+    friend class dependency_graph;
+    friend class boost::iterator_core_access;
+
+  public:
+    out_edge_iterator()
+    : e_()
+    {
+    }
+
+    explicit out_edge_iterator(edge_descriptor e)
+    : e_(e)
+    {
+    }
+
+  private:
+    edge_descriptor dereference() const
+    {
+      return e_;
+    }
+
+    bool equal(const out_edge_iterator& other) const
+    {
+      return e_ == other.e_;
+    }
+
+    void increment()
+    {
+      ++e_.idx;
+    }
+
+    void decrement()
+    {
+      --e_.idx;
+    }
+
+    void advance(std::ptrdiff_t n)
+    {
+      e_.idx = static_cast<std::uint32_t>(e_.idx + n);
+    }
+
+    std::ptrdiff_t distance_to(const out_edge_iterator& other) const
+    {
+      return static_cast<std::ptrdiff_t>(other.e_.idx) -
+             static_cast<std::ptrdiff_t>(e_.idx);
+    }
+
+  private:
+    edge_descriptor e_;
+  };
+
+  class vertex_iterator final
+  : public boost::iterator_facade<vertex_iterator,
+                                  vertex_descriptor,
+                                  boost::forward_traversal_tag,
+                                  vertex_descriptor>
+  {
+    friend class dependency_graph;
+    friend class boost::iterator_core_access;
+
+  public:
+    vertex_iterator()
+    : p_graph_()
+    , v_()
+    {
+    }
+
+    vertex_iterator(const dependency_graph* p_graph, vertex_descriptor v)
+    : p_graph_(p_graph)
+    , v_(v)
+    {
+    }
+
+  private:
+    vertex_descriptor dereference() const
+    {
+      return v_;
+    }
+
+    bool equal(const vertex_iterator& other) const
+    {
+      return v_ == other.v_;
+    }
+
+    void increment()
+    {
+      do
+      {
+        ++v_;
+      } while (v_ < p_graph_->size_ && !p_graph_->live_[v_]);
+    }
+
+  private:
+    const dependency_graph* p_graph_;
+    vertex_descriptor v_;
+  };
+
+  /// Iterates consumers starting from the most recently added one.
+  class consumer_iterator final
+  : public boost::iterator_facade<consumer_iterator,
+                                  vertex_descriptor,
+                                  boost::forward_traversal_tag,
+                                  vertex_descriptor>
   {
-    CHECK_CONDITION_DEBUG(vertex_registry_.find(v) != vertex_registry_.end());
+    friend class boost::iterator_core_access;
+
+  public:
+    consumer_iterator()
+    : p_graph_()
+    , e_()
+    {
+    }
+
+    consumer_iterator(const dependency_graph* p_graph, edge_descriptor e)
+    : p_graph_(p_graph)
+    , e_(e)
+    {
+    }
+
+  private:
+    vertex_descriptor dereference() const
+    {
+      return e_.u;
+    }
+
+    bool equal(const consumer_iterator& other) const
+    {
+      return e_ == other.e_;
+    }
+
+    void increment()
+    {
+      e_ = p_graph_->record_(e_).next_consumer;
+    }
+
+  private:
+    const dependency_graph* p_graph_;
+    edge_descriptor e_;
+  };
+
+  using consumer_range = boost::iterator_range<consumer_iterator>;
 
-    dependency_graph_base& g = *this;
+public:
+  explicit dependency_graph(const pool_allocator<char>& allocator);
+  ~dependency_graph();
+
+  dependency_graph(const dependency_graph&) = delete;
+  dependency_graph& operator=(const dependency_graph&) = delete;
 
-    return g[v];
+  vertex& operator[](vertex_descriptor v)
+  {
+    return stored_(v).properties;
   }
 
-  const vertex& operator[](const vertex_descriptor& v) const
+  const vertex& operator[](vertex_descriptor v) const
   {
-    CHECK_CONDITION_DEBUG(vertex_registry_.find(v) != vertex_registry_.end());
+    return stored_(v).properties;
+  }
+
+  friend vertex_descriptor add_vertex(vertex properties, dependency_graph& g);
+
+  friend void remove_vertex(vertex_descriptor v, dependency_graph& g);
+
+  friend std::pair<edge_descriptor, bool>
+  add_edge(vertex_descriptor u, vertex_descriptor v, dependency_graph& g);
+
+  friend void remove_edge(const edge_descriptor& e, dependency_graph& g);
+
+  friend std::pair<out_edge_iterator, out_edge_iterator>
+  out_edges(vertex_descriptor u, const dependency_graph& g)
+  {
+    const auto count = g.stored_(u).out_edges.size();
+
+    return std::make_pair(
+      out_edge_iterator(edge_descriptor(u, 0)),
+      out_edge_iterator(
+        edge_descriptor(u, static_cast<std::uint32_t>(count))));
+  }
+
+  friend degree_size_type out_degree(vertex_descriptor u,
+                                     const dependency_graph& g)
+  {
+    return g.stored_(u).out_edges.size();
+  }
 
-    const dependency_graph_base& g = *this;
+  friend vertex_descriptor source(const edge_descriptor& e,
+                                  const dependency_graph&)
+  {
+    return e.u;
+  }
 
-    return g[v];
+  friend vertex_descriptor target(const edge_descriptor& e,
+                                  const dependency_graph& g)
+  {
+    return g.record_(e).target;
   }
 
-  dependency_graph_base::edge_property_type&
-  operator[](const dependency_graph_base::edge_descriptor& e)
+  friend std::pair<vertex_iterator, vertex_iterator>
+  vertices(const dependency_graph& g);
+
+  friend vertices_size_type num_vertices(const dependency_graph& g)
   {
-    dependency_graph_base& g = *this;
+    return g.num_vertices_;
+  }
 
-    return g[e];
+  /// Tells whether `v` refers to a vertex that was not removed.
+  friend bool contains_vertex(vertex_descriptor v, const dependency_graph& g)
+  {
+    return g.is_valid_(v);
   }
 
-  const dependency_graph_base::edge_property_type&
-  operator[](const dependency_graph_base::edge_descriptor& e) const
+  /// Gets the number of vertices removed from the slot of `v` so far, which
+  /// tells apart the vertices taking the same slot one after another.
+  friend std::uint32_t generation(vertex_descriptor v,
+                                  const dependency_graph& g)
   {
-    const dependency_graph_base& g = *this;
+    CHECK_PRECONDITION(v < g.size_);
 
-    return g[e];
+    return g.generations_[v];
   }
 
-  friend vertex_descriptor add_vertex(vertex properties, dependency_graph& g)
+  friend consumer_range consumers(vertex_descriptor v,
+                                  const dependency_graph& g)
   {
-    dependency_graph_base& base_g = g;
+    return consumer_range(consumer_iterator(&g, g[v].consumers.first),
+                          consumer_iterator(&g, edge_descriptor()));
+  }
 
-    const auto v = add_vertex(properties, base_g);
+  /// Gets the consumer which was added first and is still there.
+  friend vertex_descriptor earliest_consumer(vertex_descriptor v,
+                                             const dependency_graph& g)
+  {
+    CHECK_PRECONDITION(!g[v].consumers.empty());
+
+    return g[v].consumers.last.u;
+  }
 
-    CHECK_CONDITION_DEBUG(g.vertex_registry_.insert(v).second);
+  /// Adds the source of the edge to the consumers of its target.
+  friend void link_consumer(const edge_descriptor& e, dependency_graph& g);
+
+  friend void unlink_consumer(const edge_descriptor& e, dependency_graph& g);
+
+  friend bool is_linked_consumer(const edge_descriptor& e,
+                                 const dependency_graph& g)
+  {
+    const auto& record = g.record_(e);
 
-    return v;
+    return record.prev_consumer != edge_descriptor() ||
+           g[record.target].consumers.first == e;
   }
 
-  friend void remove_vertex(vertex_descriptor v, dependency_graph& g)
+  /// Gets the nodes of the targets of the linked out-edges of `u`.
+  ///
+  /// The array is maintained by `link_consumer()` and `unlink_consumer()`,
+  /// so it is ready to be passed to `node::update()` as is.
+  ///
+  friend std::pair<const node**, std::size_t>
+  active_args(vertex_descriptor u, dependency_graph& g)
   {
-    CHECK_CONDITION_DEBUG(g.vertex_registry_.erase(v) == 1);
+    auto& args = g.stored_(u).args;
 
-    dependency_graph_base& base_g = g;
+    return std::make_pair(args.data(), args.size());
+  }
+
+  friend std::pair<const node* const*, std::size_t>
+  active_args(vertex_descriptor u, const dependency_graph& g)
+  {
+    const auto& args = g.stored_(u).args;
 
-    remove_vertex(v, base_g);
+    return std::make_pair(args.data(), args.size());
   }
 
 private:
-#ifndef NDEBUG
-  std::unordered_set<vertex_descriptor> vertex_registry_;
-#endif
-};
+  bool is_valid_(vertex_descriptor v) const
+  {
+    return v != vertex_descriptor() && v < size_ && live_[v];
+  }
+
+  stored_vertex& stored_(vertex_descriptor v)
+  {
+    CHECK_CONDITION_DEBUG(is_valid_(v));
+
+    return reinterpret_cast<stored_vertex&>(
+      chunks_[v >> chunk_bits][v & (chunk_size - 1)]);
+  }
+
+  const stored_vertex& stored_(vertex_descriptor v) const
+  {
+    CHECK_CONDITION_DEBUG(is_valid_(v));
 
-static_assert(
-  std::is_same<vertex_descriptor,
-               boost::graph_traits<dependency_graph>::vertex_descriptor>::value,
-  "wrong vertex_descriptor type");
+    return reinterpret_cast<const stored_vertex&>(
+      chunks_[v >> chunk_bits][v & (chunk_size - 1)]);
+  }
+
+  edge_record& record_(const edge_descriptor& e)
+  {
+    CHECK_CONDITION_DEBUG(e.idx < stored_(e.u).out_edges.size());
+
+    return stored_(e.u).out_edges[e.idx];
+  }
+
+  const edge_record& record_(const edge_descriptor& e) const
+  {
+    CHECK_CONDITION_DEBUG(e.idx < stored_(e.u).out_edges.size());
 
-using edge_descriptor = boost::graph_traits<dependency_graph>::edge_descriptor;
+    return stored_(e.u).out_edges[e.idx];
+  }
+
+  vertex_descriptor allocate_slot_();
+
+  // Position of the node of `e` in the active arguments of its source
+  std::size_t arg_position_(const edge_descriptor& e) const;
+
+private:
+  pool_allocator<edge_record> edges_allocator_;
+  std::vector<slot*, memory_allocator<slot*>> chunks_;
+  std::vector<bool, memory_allocator<bool>> live_;
+  std::vector<std::uint32_t, memory_allocator<std::uint32_t>> generations_;
+  vertex_descriptor free_list_;
+  vertex_descriptor size_;
+  vertices_size_type num_vertices_;
+};
 
 // TODO: get rid of wrappers in engine.inl for the methods below
 inline bool is_active_data_dependency(edge_descriptor e,
@@ -306,7 +557,7 @@ inline bool is_active_data_dependency(edge_descriptor e,
 {
   CHECK_PRECONDITION(e != edge_descriptor());
 
-  return g[e] != active_edge_ticket();
+  return is_linked_consumer(e, g);
 }
 
 inline bool is_active_node(vertex_descriptor v, const dependency_graph& g)
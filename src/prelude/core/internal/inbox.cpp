@@ -0,0 +1,145 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#include <dataflow/prelude/core/internal/inbox.h>
+
+#include "config.h"
+
+#include <exception>
+
+namespace dataflow
+{
+namespace internal
+{
+inbox::message::message(node_id id, bool overwrites)
+: p_next_(nullptr)
+, id_(id)
+, overwrites_(overwrites)
+{
+}
+
+inbox::message::~message()
+{
+}
+
+inbox::inbox()
+: p_head_(nullptr)
+, overwritten_()
+, wakeup_()
+{
+}
+
+inbox::~inbox() noexcept
+{
+  auto p_message = p_head_.load(std::memory_order_acquire);
+
+  while (p_message)
+  {
+    const auto p_next = p_message->p_next_;
+    delete p_message;
+    p_message = p_next;
+  }
+}
+
+void inbox::post(std::unique_ptr<message> p_message)
+{
+  CHECK_PRECONDITION(p_message != nullptr);
+
+  const auto p = p_message.release();
+
+  auto p_head = p_head_.load(std::memory_order_relaxed);
+
+  do
+  {
+    p->p_next_ = p_head;
+  } while (!p_head_.compare_exchange_weak(
+    p_head, p, std::memory_order_release, std::memory_order_relaxed));
+
+  // `p` may be already delivered by now, so it is not touched anymore
+  if (!p_head && wakeup_)
+    wakeup_();
+}
+
+bool inbox::empty() const
+{
+  return p_head_.load(std::memory_order_relaxed) == nullptr;
+}
+
+void inbox::set_wakeup(std::function<void()> wakeup)
+{
+  wakeup_ = std::move(wakeup);
+}
+
+std::size_t inbox::deliver()
+{
+  auto p_message = p_head_.exchange(nullptr, std::memory_order_acquire);
+
+  // Walks the messages from the most recent one, drops the obsolete ones and
+  // reverses the rest into the posting order.
+  message* p_first = nullptr;
+
+  overwritten_.clear();
+
+  while (p_message)
+  {
+    const auto p_next = p_message->p_next_;
+
+    if (overwritten_.count(p_message->id_))
+    {
+      delete p_message;
+    }
+    else
+    {
+      if (p_message->overwrites_)
+        overwritten_.insert(p_message->id_);
+
+      p_message->p_next_ = p_first;
+      p_first = p_message;
+    }
+
+    p_message = p_next;
+  }
+
+  std::size_t count = 0;
+  std::exception_ptr p_error;
+
+  while (p_first)
+  {
+    const std::unique_ptr<message> p_current(p_first);
+
+    p_first = p_first->p_next_;
+
+    try
+    {
+      p_current->deliver();
+      ++count;
+    }
+    catch (...)
+    {
+      if (!p_error)
+        p_error = std::current_exception();
+    }
+  }
+
+  if (p_error)
+    std::rethrow_exception(p_error);
+
+  return count;
+}
+} // internal
+} // dataflow
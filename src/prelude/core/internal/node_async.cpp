@@ -0,0 +1,61 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#include <dataflow/prelude/core/internal/node_async.h>
+
+#include "engine.h"
+
+#include <exception>
+
+namespace dataflow
+{
+void internal::run_node_async(node_id id,
+                              std::function<std::function<bool()>()> job)
+{
+  const auto p_inbox = &engine::instance().get_inbox();
+
+  engine::instance().run_async([p_inbox, id, job]() {
+    std::function<bool()> f;
+
+    try
+    {
+      f = job();
+    }
+    catch (...)
+    {
+      const auto p_error = std::current_exception();
+
+      p_inbox->post(inbox::make_message(
+        id, false, [p_error]() { std::rethrow_exception(p_error); }));
+
+      return;
+    }
+
+    p_inbox->post(inbox::make_message(id, false, [id, f]() {
+      if (!f())
+        return;
+
+      auto& e = engine::instance();
+      const auto v = converter::convert(id);
+
+      if (e.is_active_node(v))
+        e.schedule(v);
+    }));
+  });
+}
+} // dataflow
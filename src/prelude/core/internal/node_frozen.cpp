@@ -0,0 +1,270 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#include <dataflow/prelude/core/internal/node_frozen.h>
+
+#include "engine.h"
+
+#include <stack>
+#include <unordered_map>
+
+namespace dataflow
+{
+namespace internal
+{
+namespace
+{
+// Tells whether the node can be taken over by a program
+bool absorbable(const engine& e, vertex_descriptor v)
+{
+  const auto& graph = e.graph();
+
+  return !e.is_active_node(v) && !e.is_persistent_node(v) &&
+         !e.is_conditional_node(v) && !e.is_eager_node(v) && !graph[v].shared &&
+         out_degree(v, graph) > 0 && graph[v].p_node->retainable();
+}
+}
+
+frozen_program::frozen_program(const ref& x)
+: root_(x)
+, last_run_(0)
+{
+  auto& e = engine::instance();
+  const auto& graph = e.graph();
+
+  const auto root = converter::convert(x.id());
+
+  if (!absorbable(e, root))
+    return;
+
+  // Absorbable nodes reachable from the root along with the number of edges
+  // leading to them from the other absorbable nodes
+  std::unordered_map<vertex_descriptor, std::size_t> candidates;
+  std::stack<vertex_descriptor> stack;
+
+  candidates.emplace(root, 0);
+  stack.push(root);
+
+  while (!stack.empty())
+  {
+    const auto v = stack.top();
+    stack.pop();
+
+    for (auto es = out_edges(v, graph); es.first != es.second; ++es.first)
+    {
+      const auto u = target(*es.first, graph);
+
+      if (!absorbable(e, u))
+        continue;
+
+      const auto it = candidates.find(u);
+
+      if (it == candidates.end())
+      {
+        candidates.emplace(u, 1);
+        stack.push(u);
+      }
+      else
+      {
+        ++it->second;
+      }
+    }
+  }
+
+  // A node referenced from outside stays in the engine, and so do the nodes
+  // it references. The root is referenced by the caller and by `root_`, the
+  // rest of the subgraph is expected to be referenced by the root only.
+  bool removed = true;
+  while (removed)
+  {
+    removed = false;
+
+    for (auto it = candidates.begin(); it != candidates.end();)
+    {
+      const auto v = it->first;
+
+      if (graph[v].ref_count() == it->second + (v == root ? 2 : 0))
+      {
+        ++it;
+        continue;
+      }
+
+      for (auto es = out_edges(v, graph); es.first != es.second; ++es.first)
+      {
+        const auto jt = candidates.find(target(*es.first, graph));
+
+        if (jt != candidates.end() && jt != it)
+          --jt->second;
+      }
+
+      it = candidates.erase(it);
+      removed = true;
+    }
+  }
+
+  if (candidates.find(root) == candidates.end())
+    return;
+
+  // Postorder of the depth-first search puts the root last
+  std::unordered_map<vertex_descriptor, std::size_t> indices;
+  std::vector<vertex_descriptor> order;
+  std::stack<std::pair<vertex_descriptor, bool>> visits;
+
+  visits.push(std::make_pair(root, false));
+
+  while (!visits.empty())
+  {
+    const auto visit = visits.top();
+    visits.pop();
+
+    const auto v = visit.first;
+
+    if (visit.second)
+    {
+      indices.emplace(v, order.size());
+      order.push_back(v);
+      continue;
+    }
+
+    if (indices.find(v) != indices.end())
+      continue;
+
+    visits.push(std::make_pair(v, true));
+
+    for (auto es = out_edges(v, graph); es.first != es.second; ++es.first)
+    {
+      const auto u = target(*es.first, graph);
+
+      if (candidates.find(u) != candidates.end() &&
+          indices.find(u) == indices.end())
+        visits.push(std::make_pair(u, false));
+    }
+  }
+
+  // Operands are encoded after the inputs are known
+  std::unordered_map<vertex_descriptor, std::size_t> input_indices;
+  std::vector<std::pair<bool, std::size_t>> operands;
+
+  offsets_.push_back(0);
+
+  for (const auto v : order)
+  {
+    for (auto es = out_edges(v, graph); es.first != es.second; ++es.first)
+    {
+      const auto u = target(*es.first, graph);
+
+      if (candidates.find(u) != candidates.end())
+      {
+        operands.push_back(std::make_pair(false, indices.at(u)));
+      }
+      else
+      {
+        const auto it = input_indices.emplace(u, inputs_.size());
+
+        if (it.second)
+        {
+          inputs_.push_back(converter::convert(u));
+          e.track_changes(u);
+        }
+
+        operands.push_back(std::make_pair(true, it.first->second));
+      }
+    }
+
+    offsets_.push_back(operands.size());
+
+    nodes_.push_back(graph[v].p_node);
+    ids_.push_back(converter::convert(v));
+  }
+
+  for (const auto& operand : operands)
+  {
+    operands_.push_back(operand.first ? operand.second
+                                      : inputs_.size() + operand.second);
+  }
+
+  changed_.resize(inputs_.size() + nodes_.size());
+}
+
+bool frozen_program::empty() const
+{
+  return nodes_.empty();
+}
+
+const std::vector<node_id>& frozen_program::inputs() const
+{
+  return inputs_;
+}
+
+void frozen_program::activate(const discrete_time& t0)
+{
+  for (std::size_t i = 0; i < nodes_.size(); ++i)
+    nodes_[i]->activate(ids_[i], t0);
+}
+
+const node* frozen_program::run(const node** p_inputs,
+                                std::size_t inputs_count,
+                                bool initialized)
+{
+  CHECK_PRECONDITION(inputs_count == inputs_.size());
+  CHECK_PRECONDITION(!nodes_.empty());
+
+  const auto& e = engine::instance();
+
+  for (std::size_t j = 0; j < inputs_count; ++j)
+  {
+    changed_[j] = !initialized ||
+                  e.last_change(converter::convert(inputs_[j])) > last_run_;
+  }
+
+  for (std::size_t i = 0; i < nodes_.size(); ++i)
+  {
+    bool dirty = !initialized;
+
+    args_.clear();
+
+    for (auto k = offsets_[i]; k != offsets_[i + 1]; ++k)
+    {
+      const auto j = operands_[k];
+
+      dirty = dirty || changed_[j];
+
+      args_.push_back(j < inputs_count ? p_inputs[j]
+                                       : nodes_[j - inputs_count]);
+    }
+
+    const auto status =
+      dirty ? nodes_[i]->update(ids_[i], initialized, &args_[0], args_.size())
+            : update_status::nothing;
+
+    changed_[inputs_count + i] =
+      (status & update_status::updated) != update_status::nothing;
+  }
+
+  last_run_ = e.pumps_count();
+
+  return nodes_.back();
+}
+
+void frozen_program::deactivate()
+{
+  for (std::size_t i = 0; i < nodes_.size(); ++i)
+    nodes_[i]->deactivate(ids_[i]);
+}
+} // internal
+} // dataflow
@@ -22,6 +22,8 @@
 #include "config.h"
 #include "engine.h"
 
+#include <array>
+
 namespace dataflow
 {
 namespace internal
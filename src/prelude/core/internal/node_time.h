@@ -41,6 +41,11 @@ public:
     ++next_value_;
   }
 
+  std::size_t next_value() const
+  {
+    return next_value_;
+  }
+
 private:
   virtual update_status update_(node_id id,
                                 bool initialized,
@@ -52,7 +52,37 @@ ref nodes_factory::add_(node* p_node,
     args_count,
     (flags & node_flags::eager) != node_flags::none,
     false,
-    (flags & node_flags::pump) != node_flags::none)));
+    (flags & node_flags::pump) != node_flags::none,
+    (flags & node_flags::concurrent) != node_flags::none)));
+}
+
+node_id nodes_factory::find_shared_(const std::type_info& type,
+                                    const node_id* p_args,
+                                    std::size_t args_count,
+                                    node_flags flags)
+{
+  if ((flags & node_flags::pump) != node_flags::none)
+    return node_id();
+
+  return converter::convert(engine::instance().find_shared_node(
+    type,
+    p_args,
+    args_count,
+    (flags & node_flags::eager) != node_flags::none,
+    (flags & node_flags::concurrent) != node_flags::none));
+}
+
+ref nodes_factory::add_shared_(node* p_node,
+                               const node_id* p_args,
+                               std::size_t args_count,
+                               node_flags flags)
+{
+  const auto x = add_(p_node, p_args, args_count, flags);
+
+  if ((flags & node_flags::pump) == node_flags::none)
+    engine::instance().share_node(converter::convert(x.id()));
+
+  return x;
 }
 
 ref nodes_factory::add_conditional_(node* p_node,
@@ -74,6 +104,11 @@ ref nodes_factory::add_constant_(node* p_node)
     converter::convert(engine::instance().add_persistent_node(p_node)));
 }
 
+bool nodes_factory::can_fold(const node_id* p_args, std::size_t args_count)
+{
+  return engine::instance().can_fold(p_args, args_count);
+}
+
 ref nodes_factory::get_time_()
 {
   return ref(converter::convert(engine::instance().get_time_node()));
@@ -0,0 +1,114 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#include "profiler.h"
+
+#include "config.h"
+
+#include <algorithm>
+
+namespace dataflow
+{
+namespace internal
+{
+namespace
+{
+void accumulate(profiler::record& total, const profiler::record& r)
+{
+  total.updates_count += r.updates_count;
+  total.total_update_ns += r.total_update_ns;
+  total.max_update_ns = std::max(total.max_update_ns, r.max_update_ns);
+  total.activations_count += r.activations_count;
+  total.deactivations_count += r.deactivations_count;
+}
+}
+
+profiler::profiler()
+: records_()
+, forgotten_()
+{
+}
+
+void profiler::record_activation(vertex_descriptor v)
+{
+  ++at_(v).activations_count;
+}
+
+void profiler::record_deactivation(vertex_descriptor v)
+{
+  ++at_(v).deactivations_count;
+}
+
+void profiler::record_update(vertex_descriptor v,
+                             clock_type::duration duration)
+{
+  CHECK_PRECONDITION(v < records_.size());
+
+  const auto ns = static_cast<std::uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+
+  auto& r = records_[v];
+
+  ++r.updates_count;
+  r.total_update_ns += ns;
+  r.max_update_ns = std::max(r.max_update_ns, ns);
+}
+
+void profiler::forget(vertex_descriptor v, const std::string& label)
+{
+  if (v >= records_.size())
+    return;
+
+  accumulate(forgotten_[label], records_[v]);
+
+  records_[v] = record();
+}
+
+std::vector<std::pair<std::string, profiler::record>>
+profiler::collect(const dependency_graph& graph) const
+{
+  auto totals = forgotten_;
+
+  for (auto vs = vertices(graph); vs.first != vs.second; ++vs.first)
+  {
+    const auto v = *vs.first;
+
+    if (v < records_.size() && records_[v].activations_count != 0)
+      accumulate(totals[graph[v].p_node->label()], records_[v]);
+  }
+
+  return std::vector<std::pair<std::string, record>>(totals.begin(),
+                                                      totals.end());
+}
+
+void profiler::reset()
+{
+  std::fill(records_.begin(), records_.end(), record());
+
+  forgotten_.clear();
+}
+
+profiler::record& profiler::at_(vertex_descriptor v)
+{
+  if (records_.size() <= v)
+    records_.resize(v + 1, record());
+
+  return records_[v];
+}
+} // internal
+} // dataflow
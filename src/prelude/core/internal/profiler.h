@@ -0,0 +1,78 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "graph.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dataflow
+{
+namespace internal
+{
+// Collects update timings and activation counts of the vertices (see
+// `engine_options::profiling`). Records of the removed vertices are kept
+// aggregated by the labels of their nodes.
+class profiler final
+{
+public:
+  using clock_type = std::chrono::steady_clock;
+
+  struct record
+  {
+    std::uint64_t updates_count;
+    std::uint64_t total_update_ns;
+    std::uint64_t max_update_ns;
+    std::uint64_t activations_count;
+    std::uint64_t deactivations_count;
+  };
+
+public:
+  profiler();
+
+  void record_activation(vertex_descriptor v);
+  void record_deactivation(vertex_descriptor v);
+
+  // Can be called concurrently for different vertices, which are already
+  // activated once.
+  void record_update(vertex_descriptor v, clock_type::duration duration);
+
+  void forget(vertex_descriptor v, const std::string& label);
+
+  // Records aggregated by labels
+  std::vector<std::pair<std::string, record>>
+  collect(const dependency_graph& graph) const;
+
+  void reset();
+
+private:
+  record& at_(vertex_descriptor v);
+
+private:
+  std::vector<record> records_;
+  std::unordered_map<std::string, record> forgotten_;
+};
+} // internal
+} // dataflow
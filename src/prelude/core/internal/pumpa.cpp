@@ -1,4 +1,3 @@
-
 //  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
 //
 //  This file is part of Dataflow++.
@@ -24,15 +23,49 @@ namespace dataflow
 {
 namespace internal
 {
-pumpa::pumpa(const memory_allocator<char>& allocator, engine_options options)
+namespace
+{
+// Waves smaller than this are updated in the pumping thread, since
+// synchronization with the workers costs more than the updates themselves.
+const std::size_t min_parallel_wave_size = 16;
+
+// The clock is read once per this number of updates during interruptible
+// pumps, which also guarantees some progress of every such pump.
+const std::size_t deadline_check_interval = 32;
+
+// Number of vertices visited while looking for a path from the wave to a
+// candidate vertex. When exceeded, the candidate is assumed to depend on the
+// wave, which is always safe.
+const std::size_t max_wave_dependency_search = 64;
+}
+
+pumpa::pumpa(const memory_allocator<char>& allocator,
+             engine_options options,
+             profiler* p_profiler,
+             tracer& tracer)
 : options_(options)
+, p_profiler_(p_profiler)
+, tracer_(tracer)
 , pumping_started_(false)
-, args_buffer_(allocator)
+, interrupted_(false)
+, next_deadline_check_(0)
 , next_update_(allocator)
+, update_queue_(allocator)
+, wave_(allocator)
+, wave_members_(allocator)
+, wave_statuses_(allocator)
+, wave_reused_(allocator)
+, wave_search_(allocator)
+, chains_(allocator)
+, chain_heads_(allocator)
+, stamps_(allocator)
+, pumps_count_(0)
 , metadata_(allocator)
 , p_no_metadata_(nullptr)
 , changed_nodes_count_(0)
 , updated_nodes_count_(0)
+, previous_rounds_changed_nodes_count_(0)
+, previous_rounds_updated_nodes_count_(0)
 {
 }
 
@@ -50,6 +83,20 @@ std::size_t pumpa::updated_nodes_count() const
   return updated_nodes_count_;
 }
 
+std::size_t pumpa::pump_changed_nodes_count() const
+{
+  CHECK_PRECONDITION(!pumping_started_);
+
+  return previous_rounds_changed_nodes_count_ + changed_nodes_count_;
+}
+
+std::size_t pumpa::pump_updated_nodes_count() const
+{
+  CHECK_PRECONDITION(!pumping_started_);
+
+  return previous_rounds_updated_nodes_count_ + updated_nodes_count_;
+}
+
 void pumpa::schedule_for_next_update(topological_position position)
 {
   CHECK_PRECONDITION(pumping_started_);
@@ -58,14 +105,85 @@ void pumpa::schedule_for_next_update(topological_position position)
     next_update_.push_back(position);
 }
 
+void pumpa::retire(vertex_descriptor v, bool value_retained)
+{
+  CHECK_PRECONDITION((options_ & engine_options::retain_values) !=
+                     engine_options::nothing);
+
+  if (stamps_.size() <= v)
+    stamps_.resize(v + 1, stamps{0, 0});
+
+  // Outside of pumping the values are up to date with the last pump
+  const auto now = pumping_started_ ? pumps_count_ : pumps_count_ + 1;
+
+  if (value_retained)
+  {
+    stamps_[v].retired = now;
+  }
+  else
+  {
+    // The value is reset, so the consumers must not rely on it
+    stamps_[v].changed = now;
+    stamps_[v].retired = 0;
+  }
+}
+
+void pumpa::forget(vertex_descriptor v)
+{
+  unfuse(v);
+
+  if (v < stamps_.size())
+    stamps_[v] = stamps{0, 0};
+}
+
+void pumpa::unfuse(vertex_descriptor v)
+{
+  if (v >= chain_heads_.size() || chain_heads_[v] == vertex_descriptor())
+    return;
+
+  const auto it = chains_.find(chain_heads_[v]);
+
+  CHECK_CONDITION(it != chains_.end());
+
+  chain_heads_[it->first] = vertex_descriptor();
+
+  for (const auto u : it->second)
+    chain_heads_[u] = vertex_descriptor();
+
+  chains_.erase(it);
+}
+
+std::uint64_t pumpa::last_change(vertex_descriptor v) const
+{
+  return v < stamps_.size() ? stamps_[v].changed : 0;
+}
+
+std::uint64_t pumpa::pumps_count() const
+{
+  return pumps_count_;
+}
+
 void pumpa::set_metadata(const node* p_node,
                          std::shared_ptr<const metadata> p_metadata)
 {
-  CHECK_CONDITION(metadata_.find(p_node) == metadata_.end());
+  // Outside of the pumping the metadata can be replaced, since several
+  // changes of the same node are merged within a batch.
+  CHECK_CONDITION(!pumping_started_ ||
+                  metadata_.find(p_node) == metadata_.end());
+
+  // Some consumers of the node may have been updated by the interrupted pump
+  // already, so none of them can rely on the merged metadata
+  if (interrupted_ && metadata_.find(p_node) != metadata_.end())
+    p_metadata = nullptr;
 
   metadata_[p_node] = std::move(p_metadata);
 }
 
+bool pumpa::has_metadata(const node* p_node) const
+{
+  return metadata_.find(p_node) != metadata_.end();
+}
+
 const std::shared_ptr<const metadata>& pumpa::get_metadata(const node* p_node)
 {
   const auto it = metadata_.find(p_node);
@@ -76,32 +194,121 @@ const std::shared_ptr<const metadata>& pumpa::get_metadata(const node* p_node)
   return it->second;
 }
 
-void pumpa::pump(dependency_graph& graph,
+bool pumpa::pump(dependency_graph& graph,
                  topological_list& order,
-                 vertex_descriptor time_node_v)
+                 vertex_descriptor time_node_v,
+                 time_point deadline)
+{
+  CHECK_PRECONDITION(!pumping_started_);
+  CHECK_PRECONDITION(!interrupted_);
+
+  pumping_started_ = true;
+
+  const auto start = tracer_.now();
+
+  changed_nodes_count_ = 0;
+  updated_nodes_count_ = 0;
+  previous_rounds_changed_nodes_count_ = 0;
+  previous_rounds_updated_nodes_count_ = 0;
+
+  start_tick_(graph, order, time_node_v);
+
+  const auto finished = continue_(graph, order, time_node_v, deadline);
+
+  tracer_.record(tracer::event_type::pump,
+                 start,
+                 "pump",
+                 current_tick_(graph, time_node_v),
+                 finished);
+
+  return finished;
+}
+
+bool pumpa::resume(dependency_graph& graph,
+                   topological_list& order,
+                   vertex_descriptor time_node_v,
+                   time_point deadline)
 {
   CHECK_PRECONDITION(!pumping_started_);
+  CHECK_PRECONDITION(interrupted_);
 
   pumping_started_ = true;
+  interrupted_ = false;
+
+  const auto start = tracer_.now();
+
+  const auto finished = continue_(graph, order, time_node_v, deadline);
+
+  tracer_.record(tracer::event_type::pump,
+                 start,
+                 "pump",
+                 current_tick_(graph, time_node_v),
+                 finished);
+
+  return finished;
+}
+
+bool pumpa::is_pumping() const
+{
+  return pumping_started_;
+}
+
+bool pumpa::is_interrupted() const
+{
+  return interrupted_;
+}
+
+bool pumpa::continue_(dependency_graph& graph,
+                      topological_list& order,
+                      vertex_descriptor time_node_v,
+                      time_point deadline)
+{
+  next_deadline_check_ = updated_nodes_count_ + deadline_check_interval;
 
   try
   {
-    pump_(graph, order, time_node_v);
-
-    while (!next_update_.empty())
+    for (;;)
     {
+      const auto start = tracer_.now();
+
+      const auto finished = (options_ & engine_options::parallel_update) !=
+                                engine_options::nothing
+                              ? update_in_parallel_(graph, order, deadline)
+                              : update_sequentially_(graph, order, deadline);
+
+      tracer_.record(tracer::event_type::round,
+                     start,
+                     "round",
+                     current_tick_(graph, time_node_v),
+                     updated_nodes_count_);
+
+      if (!finished)
+      {
+        pumping_started_ = false;
+        interrupted_ = true;
+
+        return false;
+      }
+
+      CHECK_CONDITION(order.begin_marked() == order.end_marked());
+
+      metadata_.clear();
+
+      if (next_update_.empty())
+        break;
+
       for (auto pos : next_update_)
-        order.mark(pos);
+        mark_(*pos, graph, order);
 
       next_update_.clear();
 
-      pump_(graph, order, time_node_v);
+      start_tick_(graph, order, time_node_v);
     }
   }
   catch (...)
   {
     pumping_started_ = false;
-    args_buffer_.clear();
+    clear_wave_();
     metadata_.clear();
     throw;
   }
@@ -110,19 +317,22 @@ void pumpa::pump(dependency_graph& graph,
 
   CHECK_POSTCONDITION(!pumping_started_);
   CHECK_POSTCONDITION(metadata_.empty());
-}
 
-bool pumpa::is_pumping() const
-{
-  return pumping_started_;
+  return true;
 }
 
-void pumpa::pump_(dependency_graph& graph,
-                  topological_list& order,
-                  vertex_descriptor time_node_v)
+void pumpa::start_tick_(dependency_graph& graph,
+                        topological_list& order,
+                        vertex_descriptor time_node_v)
 {
+  previous_rounds_changed_nodes_count_ += changed_nodes_count_;
+  previous_rounds_updated_nodes_count_ += updated_nodes_count_;
+
   changed_nodes_count_ = 0;
   updated_nodes_count_ = 0;
+  next_deadline_check_ = deadline_check_interval;
+
+  ++pumps_count_;
 
   CHECK_CONDITION(dynamic_cast<node_time*>(graph[time_node_v].p_node));
 
@@ -131,40 +341,305 @@ void pumpa::pump_(dependency_graph& graph,
   p_node_time->increment();
 
   order.mark(graph[time_node_v].position);
+}
+
+std::size_t pumpa::current_tick_(const dependency_graph& graph,
+                                 vertex_descriptor time_node_v)
+{
+  CHECK_CONDITION(dynamic_cast<node_time*>(graph[time_node_v].p_node));
+
+  return static_cast<const node_time*>(graph[time_node_v].p_node)
+    ->next_value();
+}
+
+bool pumpa::deadline_passed_(time_point deadline)
+{
+  if (deadline == time_point::max() ||
+      updated_nodes_count_ < next_deadline_check_)
+  {
+    return false;
+  }
 
-  std::vector<vertex_descriptor> queue;
+  next_deadline_check_ = updated_nodes_count_ + deadline_check_interval;
+
+  return clock_type::now() >= deadline;
+}
+
+bool pumpa::update_sequentially_(dependency_graph& graph,
+                                 topological_list& order,
+                                 time_point deadline)
+{
+  update_queue_.clear();
 
   const auto to = order.end_marked();
   for (auto it = order.begin_marked(); it != to; it = order.begin_marked())
   {
     order.unmark(it.base());
 
-    queue.push_back(*it);
-
-    while (!queue.empty())
+    // Vertices marked before their branch got parked
+    if (graph[*it].parked)
     {
-      const auto v = queue.back();
-      queue.pop_back();
+      graph[*it].stale = true;
+      continue;
+    }
 
-      const auto p_node = graph[v].p_node;
+    update_queue_.push_back(*it);
 
-      CHECK_CONDITION(p_node);
+    while (!update_queue_.empty())
+    {
+      // The vertices left in the queue are marked to be updated on resumption
+      if (deadline_passed_(deadline))
+      {
+        for (const auto v : update_queue_)
+          order.mark(graph[v].position);
 
-      CHECK_CONDITION(args_buffer_.size() == 0);
+        return false;
+      }
 
-      for (auto es = out_edges(v, graph); es.first != es.second; ++es.first)
+      const auto v = update_queue_.back();
+      update_queue_.pop_back();
+
+      if ((update_(v, graph) & update_status::updated) ==
+          update_status::nothing)
       {
-        const auto e = *es.first;
+        continue;
+      }
+
+      const auto w =
+        (options_ & engine_options::chain_fusion) != engine_options::nothing
+          ? update_chain_(v, graph, order, deadline)
+          : v;
+
+      if (w == vertex_descriptor())
+        continue;
 
-        // Only active data dependencies get to the arguments list
-        if (is_active_data_dependency(e, graph))
-          args_buffer_.push_back(graph[target(e, graph)].p_node);
+      for (const auto u : consumers(w, graph))
+      {
+        if ((options_ & engine_options::straight_update_optimization) !=
+              engine_options::nothing &&
+            !graph[u].parked && out_degree(u, graph) == 2 &&
+            activator(u, graph) == activator(w, graph))
+        {
+          order.unmark(graph[u].position);
+          update_queue_.push_back(u);
+        }
+        else
+        {
+          mark_(u, graph, order);
+        }
       }
+    }
+  }
+
+  return true;
+}
+
+update_status pumpa::update_(vertex_descriptor v, dependency_graph& graph)
+{
+  const auto p_node = graph[v].p_node;
+
+  CHECK_CONDITION(p_node);
+
+  if (!graph[v].initialized && can_reuse_(v, graph))
+  {
+    graph[v].initialized = true;
+    stamp_(v, graph, update_status::nothing);
+
+    return update_status::nothing;
+  }
+
+  const auto status = update_node_(v, graph);
+
+  stamp_(v, graph, status);
+
+  ++updated_nodes_count_;
+
+  if ((status & update_status::updated_next) != update_status::nothing)
+  {
+    schedule_for_next_update(graph[v].position);
+  }
+
+  graph[v].initialized = true;
+
+  if ((status & update_status::updated) != update_status::nothing)
+    ++changed_nodes_count_;
+
+  return status;
+}
+
+vertex_descriptor pumpa::update_chain_(vertex_descriptor v,
+                                       dependency_graph& graph,
+                                       topological_list& order,
+                                       time_point deadline)
+{
+  const auto head =
+    v < chain_heads_.size() ? chain_heads_[v] : vertex_descriptor();
+
+  // Vertices of a chain updated on their own propagate their changes as usual
+  if (head != v && (head != vertex_descriptor() || !fuse_(v, graph)))
+    return v;
+
+  const auto& members = chains_.find(v)->second;
+
+  for (const auto u : members)
+  {
+    // The rest of the chain is updated on resumption
+    if (graph[u].parked || deadline_passed_(deadline))
+    {
+      mark_(u, graph, order);
+      return vertex_descriptor();
+    }
+
+    order.unmark(graph[u].position);
+
+    if ((update_(u, graph) & update_status::updated) == update_status::nothing)
+      return vertex_descriptor();
+
+    // The update could split the chain, e.g. by the introspection
+    if (chain_heads_[u] != v)
+      return u;
+  }
+
+  return members.back();
+}
+
+bool pumpa::fuse_(vertex_descriptor v, const dependency_graph& graph)
+{
+  chain members(chains_.get_allocator());
+
+  for (auto w = v;;)
+  {
+    const auto& w_consumers = graph[w].consumers;
+
+    if (w_consumers.empty() || w_consumers.first != w_consumers.last)
+      break;
+
+    const auto u = w_consumers.first.u;
+
+    // Only the lifts of `w` alone
+    if (!graph[u].concurrent || graph[u].tracked || graph[u].exposed ||
+        graph[u].parked || out_degree(u, graph) != 2 ||
+        activator(u, graph) != activator(w, graph) ||
+        (u < chain_heads_.size() && chain_heads_[u] != vertex_descriptor()))
+    {
+      break;
+    }
+
+    members.push_back(u);
+
+    w = u;
+  }
+
+  if (members.empty())
+    return false;
+
+  for (const auto u : members)
+  {
+    if (chain_heads_.size() <= u)
+      chain_heads_.resize(u + 1, vertex_descriptor());
+
+    chain_heads_[u] = v;
+  }
+
+  if (chain_heads_.size() <= v)
+    chain_heads_.resize(v + 1, vertex_descriptor());
+
+  chain_heads_[v] = v;
+
+  chains_.emplace(v, std::move(members));
+
+  return true;
+}
+
+update_status pumpa::update_node_(vertex_descriptor v,
+                                  dependency_graph& graph)
+{
+  // Only active data dependencies get to the arguments list
+  const auto args = active_args(v, graph);
+  const auto p_node = graph[v].p_node;
+  const auto id = converter::convert(v);
+
+  if (!p_profiler_ && !tracer_.enabled())
+    return p_node->update(id, graph[v].initialized, args.first, args.second);
+
+  const auto start = profiler::clock_type::now();
+
+  const auto status =
+    p_node->update(id, graph[v].initialized, args.first, args.second);
+
+  if (p_profiler_)
+    p_profiler_->record_update(v, profiler::clock_type::now() - start);
+
+  if (tracer_.enabled())
+  {
+    tracer_.record(tracer::event_type::update,
+                   start,
+                   p_node->label(),
+                   v,
+                   (status & update_status::updated) != update_status::nothing);
+  }
+
+  return status;
+}
+
+void pumpa::mark_(vertex_descriptor v,
+                  dependency_graph& graph,
+                  topological_list& order)
+{
+  if (graph[v].parked)
+    graph[v].stale = true;
+  else
+    order.mark(graph[v].position);
+}
+
+bool pumpa::update_in_parallel_(dependency_graph& graph,
+                                topological_list& order,
+                                time_point deadline)
+{
+  CHECK_PRECONDITION((options_ & engine_options::parallel_update) !=
+                     engine_options::nothing);
+
+  const auto update = [&](std::size_t i) {
+    if (!wave_reused_[i])
+      wave_statuses_[i] = update_node_(wave_[i], graph);
+  };
+
+  while (order.begin_marked() != order.end_marked())
+  {
+    if (deadline_passed_(deadline))
+      return false;
+
+    collect_wave_(graph, order);
+
+    wave_statuses_.resize(wave_.size(), update_status::nothing);
+
+    // Reused vertices are neither updated nor counted, as in `update_()`
+    for (const auto v : wave_)
+      wave_reused_.push_back(!graph[v].initialized && can_reuse_(v, graph));
+
+    if (wave_.size() < min_parallel_wave_size)
+    {
+      for (std::size_t i = 0; i < wave_.size(); ++i)
+        update(i);
+    }
+    else
+    {
+      thread_pool::shared().run(wave_.size(), update);
+    }
 
-      const auto status = p_node->update(converter::convert(v),
-                                         graph[v].initialized,
-                                         args_buffer_.data(),
-                                         args_buffer_.size());
+    // Statuses are processed in the topological order of the wave, so the
+    // resulting marking does not depend on the scheduling of the workers.
+    for (std::size_t i = 0; i < wave_.size(); ++i)
+    {
+      const auto v = wave_[i];
+      const auto status = wave_statuses_[i];
+
+      stamp_(v, graph, status);
+
+      graph[v].initialized = true;
+
+      if (wave_reused_[i])
+        continue;
 
       ++updated_nodes_count_;
 
@@ -173,36 +648,158 @@ void pumpa::pump_(dependency_graph& graph,
         schedule_for_next_update(graph[v].position);
       }
 
-      graph[v].initialized = true;
-
-      args_buffer_.clear();
-
       if ((status & update_status::updated) != update_status::nothing)
       {
         ++changed_nodes_count_;
 
-        for (const auto& u : graph[v].consumers)
-        {
-          if ((options_ & engine_options::straight_update_optimization) !=
-                engine_options::nothing &&
-              out_degree(u, graph) == 2 &&
-              activator(u, graph) == activator(v, graph))
-          {
-            order.unmark(graph[u].position);
-            queue.push_back(u);
-          }
-          else
-          {
-            order.mark(graph[u].position);
-          }
-        }
+        for (const auto u : consumers(v, graph))
+          mark_(u, graph, order);
       }
     }
+
+    clear_wave_();
+  }
+
+  return true;
+}
+
+bool pumpa::can_reuse_(vertex_descriptor v, const dependency_graph& graph) const
+{
+  if (v >= stamps_.size() || stamps_[v].retired == 0)
+    return false;
+
+  const auto retired = stamps_[v].retired;
+
+  auto es = out_edges(v, graph);
+
+  // Nodes without arguments get their values from outside
+  if (es.second - es.first < 2)
+    return false;
+
+  // The last out-edge leads to the activator
+  for (--es.second; es.first != es.second; ++es.first)
+  {
+    const auto u = target(*es.first, graph);
+
+    if (u < stamps_.size() && stamps_[u].changed >= retired)
+      return false;
+  }
+
+  return true;
+}
+
+void pumpa::stamp_(vertex_descriptor v,
+                   const dependency_graph& graph,
+                   update_status status)
+{
+  if ((options_ & engine_options::retain_values) == engine_options::nothing &&
+      !graph[v].tracked)
+    return;
+
+  if (stamps_.size() <= v)
+    stamps_.resize(v + 1, stamps{0, 0});
+
+  stamps_[v].retired = 0;
+
+  if ((status & update_status::updated) != update_status::nothing)
+    stamps_[v].changed = pumps_count_;
+}
+
+void pumpa::collect_wave_(dependency_graph& graph, topological_list& order)
+{
+  CHECK_PRECONDITION(wave_.empty());
+
+  // A wave is the longest run of marked vertices (in topological order)
+  // that do not depend on each other, even through unmarked vertices, which
+  // may get marked by the wave. Vertices that cannot be updated
+  // concurrently form a wave on their own.
+  const auto to = order.end_marked();
+  for (auto it = order.begin_marked(); it != to; it = order.begin_marked())
+  {
+    const auto v = *it;
+
+    // Vertices marked before their branch got parked
+    if (graph[v].parked)
+    {
+      order.unmark(it.base());
+      graph[v].stale = true;
+      continue;
+    }
+
+    if (!wave_.empty() && !graph[v].concurrent)
+      break;
+
+    if (!wave_.empty() && depends_on_wave_(v, graph, order))
+      break;
+
+    order.unmark(it.base());
+
+    wave_.push_back(v);
+    wave_members_.insert(graph[v].p_node);
+
+    if (!graph[v].concurrent)
+      break;
+  }
+
+  CHECK_POSTCONDITION(!wave_.empty() ||
+                      order.begin_marked() == order.end_marked());
+}
+
+bool pumpa::depends_on_wave_(vertex_descriptor v,
+                             const dependency_graph& graph,
+                             const topological_list& order)
+{
+  CHECK_PRECONDITION(!wave_.empty());
+
+  // Every path from the wave to `v` goes through vertices ordered after the
+  // first vertex of the wave, so the search stops at the preceding ones.
+  const auto first = graph[wave_.front()].position;
+
+  std::size_t visited = 0;
+
+  wave_search_.clear();
+  wave_search_.push_back(v);
+
+  while (!wave_search_.empty())
+  {
+    const auto w = wave_search_.back();
+    wave_search_.pop_back();
+
+    auto es = out_edges(w, graph);
+
+    // The last out-edge leads to the activator
+    if (es.first == es.second)
+      continue;
+
+    for (--es.second; es.first != es.second; ++es.first)
+    {
+      if (!is_active_data_dependency(*es.first, graph))
+        continue;
+
+      const auto u = target(*es.first, graph);
+
+      if (wave_members_.count(graph[u].p_node) != 0)
+        return true;
+
+      if (order.order(graph[u].position, first))
+        continue;
+
+      if (++visited > max_wave_dependency_search)
+        return true;
+
+      wave_search_.push_back(u);
+    }
   }
 
-  CHECK_CONDITION(order.begin_marked() == order.end_marked());
+  return false;
+}
 
-  metadata_.clear();
+void pumpa::clear_wave_()
+{
+  wave_.clear();
+  wave_members_.clear();
+  wave_statuses_.clear();
+  wave_reused_.clear();
 }
 } // internal
 } // dataflow
@@ -20,11 +20,17 @@
 
 #include "graph.h"
 #include "node_time.h"
+#include "profiler.h"
+#include "thread_pool.h"
+#include "tracer.h"
 
 #include <dataflow/prelude/core/engine_options.h>
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace dataflow
@@ -34,35 +40,180 @@ namespace internal
 class pumpa final
 {
 public:
-  pumpa(const memory_allocator<char>& allocator, engine_options options);
+  using clock_type = std::chrono::steady_clock;
+  using time_point = clock_type::time_point;
+
+public:
+  pumpa(const memory_allocator<char>& allocator,
+        engine_options options,
+        profiler* p_profiler,
+        tracer& tracer);
 
   std::size_t changed_nodes_count() const;
 
   std::size_t updated_nodes_count() const;
 
+  // Counts of the whole last pump, unlike the ones above, which are reset by
+  // each round
+  std::size_t pump_changed_nodes_count() const;
+  std::size_t pump_updated_nodes_count() const;
+
   void schedule_for_next_update(topological_position position);
 
+  // Records the deactivation of `v` (see `engine_options::retain_values`)
+  void retire(vertex_descriptor v, bool value_retained);
+
+  // Drops the records of the removed vertex `v`
+  void forget(vertex_descriptor v);
+
+  // Splits the fused chain `v` belongs to, if any (see
+  // `engine_options::chain_fusion`)
+  void unfuse(vertex_descriptor v);
+
+  // Pump of the last change of a tracked vertex (zero if never changed)
+  std::uint64_t last_change(vertex_descriptor v) const;
+
+  std::uint64_t pumps_count() const;
+
   void set_metadata(const node* p_node,
                     std::shared_ptr<const metadata> p_metadata);
+  bool has_metadata(const node* p_node) const;
   const std::shared_ptr<const metadata>& get_metadata(const node* p_node);
 
-  void pump(dependency_graph& graph,
+  // Updates the marked vertices until all the updates are done or `deadline`
+  // passes. Returns whether the updates are done. The interrupted pump is
+  // continued by `resume()`, the marked vertices being its state.
+  bool pump(dependency_graph& graph,
             topological_list& order,
-            vertex_descriptor time_node_v);
+            vertex_descriptor time_node_v,
+            time_point deadline = time_point::max());
+
+  bool resume(dependency_graph& graph,
+              topological_list& order,
+              vertex_descriptor time_node_v,
+              time_point deadline = time_point::max());
 
   bool is_pumping() const;
 
+  bool is_interrupted() const;
+
 private:
-  void pump_(dependency_graph& graph,
-             topological_list& order,
-             vertex_descriptor time_node_v);
+  bool continue_(dependency_graph& graph,
+                 topological_list& order,
+                 vertex_descriptor time_node_v,
+                 time_point deadline);
+
+  void start_tick_(dependency_graph& graph,
+                   topological_list& order,
+                   vertex_descriptor time_node_v);
+
+  bool deadline_passed_(time_point deadline);
+
+  bool update_sequentially_(dependency_graph& graph,
+                            topological_list& order,
+                            time_point deadline);
+
+  update_status update_(vertex_descriptor v, dependency_graph& graph);
+
+  // Propagates the change of `v` through the chain fused after it. Returns
+  // the last vertex of the chain, or the null vertex if the change stopped
+  // propagating or the rest of the chain got marked. Returns `v` if no chain
+  // follows it.
+  vertex_descriptor update_chain_(vertex_descriptor v,
+                                  dependency_graph& graph,
+                                  topological_list& order,
+                                  time_point deadline);
+
+  // Fuses the longest straight chain following `v`. Returns whether there is
+  // one.
+  bool fuse_(vertex_descriptor v, const dependency_graph& graph);
+
+  static std::size_t current_tick_(const dependency_graph& graph,
+                                   vertex_descriptor time_node_v);
+
+  // Calls the update of the node, measuring it for the profiler and the
+  // tracer
+  update_status update_node_(vertex_descriptor v, dependency_graph& graph);
+
+  // Marks `v` to be updated, unless it belongs to a parked branch, in which
+  // case it is only flagged as stale (see `engine::park_branch_()`)
+  static void mark_(vertex_descriptor v,
+                    dependency_graph& graph,
+                    topological_list& order);
+
+  bool update_in_parallel_(dependency_graph& graph,
+                           topological_list& order,
+                           time_point deadline);
+
+  // Tells whether the value retained by `v` is still valid, so that `v` can
+  // be activated without an update.
+  bool can_reuse_(vertex_descriptor v, const dependency_graph& graph) const;
+
+  void stamp_(vertex_descriptor v,
+              const dependency_graph& graph,
+              update_status status);
+
+  void collect_wave_(dependency_graph& graph, topological_list& order);
+
+  // Tells whether `v` depends, directly or transitively, on a vertex of the
+  // wave being collected.
+  bool depends_on_wave_(vertex_descriptor v,
+                        const dependency_graph& graph,
+                        const topological_list& order);
+
+  void clear_wave_();
 
 private:
   const engine_options options_;
+  profiler* const p_profiler_;
+  tracer& tracer_;
   bool pumping_started_;
-  std::vector<const node*, memory_allocator<const node*>> args_buffer_;
+  bool interrupted_;
+  std::size_t next_deadline_check_;
   std::vector<topological_position, memory_allocator<topological_position>>
     next_update_;
+  // Vertices updated straight by the sequential update, reused between calls
+  std::vector<vertex_descriptor, memory_allocator<vertex_descriptor>>
+    update_queue_;
+
+  // Parallel update (see `engine_options::parallel_update`)
+  std::vector<vertex_descriptor, memory_allocator<vertex_descriptor>> wave_;
+  std::unordered_set<const node*,
+                     std::hash<const node*>,
+                     std::equal_to<const node*>,
+                     memory_allocator<const node*>>
+    wave_members_;
+  std::vector<update_status, memory_allocator<update_status>> wave_statuses_;
+  std::vector<bool, memory_allocator<bool>> wave_reused_;
+  std::vector<vertex_descriptor, memory_allocator<vertex_descriptor>>
+    wave_search_;
+
+  // Chain fusion (see `engine_options::chain_fusion`). Chains are found by
+  // their first vertices and every vertex of a chain refers to the first one.
+  using chain =
+    std::vector<vertex_descriptor, memory_allocator<vertex_descriptor>>;
+
+  std::unordered_map<
+    vertex_descriptor,
+    chain,
+    std::hash<vertex_descriptor>,
+    std::equal_to<vertex_descriptor>,
+    memory_allocator<std::pair<const vertex_descriptor, chain>>>
+    chains_;
+  std::vector<vertex_descriptor, memory_allocator<vertex_descriptor>>
+    chain_heads_;
+
+  // Value retention (see `engine_options::retain_values`) and tracked
+  // vertices. Vertices store the pump of their last change and, while
+  // inactive, the first pump their retained values do not account for.
+  struct stamps
+  {
+    std::uint64_t changed;
+    std::uint64_t retired;
+  };
+
+  std::vector<stamps, memory_allocator<stamps>> stamps_;
+  std::uint64_t pumps_count_;
 
   // TODO: move to not existing yet `network` class together with graph and
   //       topological order?
@@ -79,6 +230,8 @@ private:
 
   std::size_t changed_nodes_count_;
   std::size_t updated_nodes_count_;
+  std::size_t previous_rounds_changed_nodes_count_;
+  std::size_t previous_rounds_updated_nodes_count_;
 };
 } // internal
 } // dataflow
@@ -49,6 +49,10 @@ void ref::schedule_() const
     {
       engine::instance().schedule_for_next_update(converter::convert(id_));
     }
+    else if (engine::instance().is_batching())
+    {
+      engine::instance().schedule(converter::convert(id_));
+    }
     else
     {
       engine::instance().schedule_and_pump(converter::convert(id_));
@@ -56,12 +60,32 @@ void ref::schedule_() const
   }
 }
 
-void ref::set_metadata(std::shared_ptr<const metadata> p_metadata)
+bool ref::is_batching_() const
+{
+  return engine::instance().is_batching();
+}
+
+void ref::set_metadata(std::shared_ptr<const metadata> p_metadata) const
 {
   if (engine::instance().is_active_node(converter::convert(id_)))
     engine::instance().set_metadata(get_(), std::move(p_metadata));
 }
 
+bool ref::has_metadata() const
+{
+  return engine::instance().has_metadata(get_());
+}
+
+const std::shared_ptr<const metadata>& ref::get_metadata() const
+{
+  return engine::instance().get_metadata(get_());
+}
+
+inbox& ref::get_inbox_() const
+{
+  return engine::instance().get_inbox();
+}
+
 void ref::reset_(const ref& other)
 {
   engine::instance().release(converter::convert(id_));
@@ -71,6 +95,26 @@ void ref::reset_(const ref& other)
   engine::instance().add_ref(converter::convert(id_));
 }
 
+std::uint32_t ref::node_generation_() const
+{
+  return engine::instance().node_generation(converter::convert(id_));
+}
+
+bool ref::is_alive_(node_id id, std::uint32_t generation)
+{
+  const auto v = converter::convert(id);
+
+  return engine::instance().has_node(v) &&
+         engine::instance().node_generation(v) == generation;
+}
+
+ref ref::acquire_(node_id id)
+{
+  CHECK_PRECONDITION(engine::instance().has_node(converter::convert(id)));
+
+  return ref(id);
+}
+
 ref::ref(node_id id)
 : id_(id)
 {
@@ -0,0 +1,96 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "config.h"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace dataflow
+{
+namespace internal
+{
+// Keeps the latest `capacity()` pushed items, overwriting the oldest ones.
+// Nothing is kept with zero capacity.
+template <typename T, typename Allocator = std::allocator<T>>
+class ring_buffer final
+{
+public:
+  explicit ring_buffer(std::size_t capacity = 0,
+                       const Allocator& allocator = Allocator())
+  : items_(allocator)
+  , capacity_(capacity)
+  , oldest_(0)
+  {
+  }
+
+  std::size_t capacity() const
+  {
+    return capacity_;
+  }
+
+  std::size_t size() const
+  {
+    return items_.size();
+  }
+
+  bool empty() const
+  {
+    return items_.empty();
+  }
+
+  // Items are indexed from the oldest to the latest
+  const T& operator[](std::size_t i) const
+  {
+    CHECK_PRECONDITION_DEBUG(i < items_.size());
+
+    return items_[(oldest_ + i) % items_.size()];
+  }
+
+  void push_back(T item)
+  {
+    if (items_.size() < capacity_)
+    {
+      items_.push_back(std::move(item));
+    }
+    else if (capacity_ != 0)
+    {
+      items_[oldest_] = std::move(item);
+      oldest_ = (oldest_ + 1) % capacity_;
+    }
+  }
+
+  // Removes all the items and sets the new capacity
+  void reset(std::size_t capacity)
+  {
+    items_.clear();
+    capacity_ = capacity;
+    oldest_ = 0;
+  }
+
+private:
+  std::vector<T, Allocator> items_;
+  std::size_t capacity_;
+  std::size_t oldest_;
+};
+} // internal
+} // dataflow
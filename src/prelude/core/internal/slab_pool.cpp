@@ -0,0 +1,95 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#include "slab_pool.h"
+
+namespace dataflow
+{
+namespace internal
+{
+constexpr std::size_t slab_pool::granularity;
+constexpr std::size_t slab_pool::max_block_size;
+constexpr std::size_t slab_pool::slab_size;
+
+slab_pool::slab_pool(memory_counters& counters)
+: allocator_(counters)
+, free_lists_()
+, slabs_(allocator_)
+, p_unused_begin_(nullptr)
+, p_unused_end_(nullptr)
+{
+}
+
+slab_pool::~slab_pool() noexcept
+{
+  for (const auto p_slab : slabs_)
+    allocator_.deallocate(p_slab, slab_size / sizeof(std::max_align_t));
+}
+
+void* slab_pool::allocate(std::size_t size)
+{
+  CHECK_PRECONDITION(size > 0 && size <= max_block_size);
+
+  const auto idx = size_class_(size);
+
+  if (const auto p_block = free_lists_[idx])
+  {
+    free_lists_[idx] = p_block->p_next;
+
+    return p_block;
+  }
+
+  const auto block_size = (idx + 1) * granularity;
+
+  if (static_cast<std::size_t>(p_unused_end_ - p_unused_begin_) < block_size)
+    add_slab_();
+
+  const auto p_block = p_unused_begin_;
+
+  p_unused_begin_ += block_size;
+
+  return p_block;
+}
+
+void slab_pool::deallocate(void* p, std::size_t size)
+{
+  CHECK_PRECONDITION(p != nullptr);
+  CHECK_PRECONDITION(size > 0 && size <= max_block_size);
+
+  const auto idx = size_class_(size);
+
+  const auto p_block = new (p) free_block{free_lists_[idx]};
+
+  free_lists_[idx] = p_block;
+}
+
+void slab_pool::add_slab_()
+{
+  slabs_.reserve(slabs_.size() + 1);
+
+  const auto p_slab = allocator_.allocate(slab_size / sizeof(std::max_align_t));
+
+  slabs_.push_back(p_slab);
+
+  // The tail of the previous slab is too small for the requested block, it
+  // is left unused
+  p_unused_begin_ = reinterpret_cast<char*>(p_slab);
+  p_unused_end_ = p_unused_begin_ + slab_size;
+}
+} // internal
+} // dataflow
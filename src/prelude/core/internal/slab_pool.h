@@ -0,0 +1,223 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include "config.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace dataflow
+{
+namespace internal
+{
+// Memory usage of an engine. The allocators of the engine may be used by
+// the pool workers, so the counters are atomic.
+struct memory_counters
+{
+  std::atomic<std::size_t> allocated_bytes{0};
+  // Number of allocations and their total size, not reduced by the
+  // deallocations
+  std::atomic<std::size_t> allocations_count{0};
+  std::atomic<std::size_t> allocated_bytes_total{0};
+};
+
+// Counting allocator for the memory owned by the engine.
+template <typename T> class memory_allocator
+{
+public:
+  using value_type = T;
+
+  template <typename U> struct rebind
+  {
+    using other = memory_allocator<U>;
+  };
+
+public:
+  explicit memory_allocator(memory_counters& counters) noexcept
+  : p_counters_(&counters)
+  {
+  }
+
+  template <typename U>
+  memory_allocator(const memory_allocator<U>& other) noexcept
+  : p_counters_(&other.counters())
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    const auto p = std::allocator<T>().allocate(n);
+
+    p_counters_->allocated_bytes.fetch_add(n * sizeof(T),
+                                           std::memory_order_relaxed);
+    p_counters_->allocations_count.fetch_add(1, std::memory_order_relaxed);
+    p_counters_->allocated_bytes_total.fetch_add(n * sizeof(T),
+                                                 std::memory_order_relaxed);
+
+    return p;
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept
+  {
+    p_counters_->allocated_bytes.fetch_sub(n * sizeof(T),
+                                           std::memory_order_relaxed);
+
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  memory_counters& counters() const noexcept
+  {
+    return *p_counters_;
+  }
+
+  template <typename U>
+  bool operator==(const memory_allocator<U>& other) const noexcept
+  {
+    return p_counters_ == &other.counters();
+  }
+
+  template <typename U>
+  bool operator!=(const memory_allocator<U>& other) const noexcept
+  {
+    return !(*this == other);
+  }
+
+private:
+  memory_counters* p_counters_;
+};
+
+// Size-class allocator for the small objects of the engine (nodes, edges,
+// list elements). Blocks are cut from large slabs obtained from
+// `memory_allocator`, so they are accounted for by `memory_consumption()`.
+// Freed blocks are kept for reuse and the slabs are released only together
+// with the pool. Not thread-safe.
+class slab_pool final
+{
+public:
+  static constexpr std::size_t granularity = alignof(std::max_align_t);
+  static constexpr std::size_t max_block_size = 256;
+  static constexpr std::size_t slab_size = 64 * 1024;
+
+public:
+  explicit slab_pool(memory_counters& counters);
+  ~slab_pool() noexcept;
+
+  slab_pool(const slab_pool&) = delete;
+  slab_pool& operator=(const slab_pool&) = delete;
+
+  static bool can_allocate(std::size_t size, std::size_t alignment)
+  {
+    return size > 0 && size <= max_block_size && alignment <= granularity;
+  }
+
+  void* allocate(std::size_t size);
+  void deallocate(void* p, std::size_t size);
+
+private:
+  struct free_block
+  {
+    free_block* p_next;
+  };
+
+  static std::size_t size_class_(std::size_t size)
+  {
+    return (size - 1) / granularity;
+  }
+
+  void add_slab_();
+
+private:
+  memory_allocator<std::max_align_t> allocator_;
+  std::array<free_block*, max_block_size / granularity> free_lists_;
+  std::vector<std::max_align_t*, memory_allocator<std::max_align_t*>> slabs_;
+  char* p_unused_begin_;
+  char* p_unused_end_;
+};
+
+// Allocator of the engine data structures. Small blocks are taken from the
+// `slab_pool` if one is given, everything else goes to `memory_allocator`.
+template <typename T> class pool_allocator
+{
+public:
+  using value_type = T;
+
+  template <typename U> struct rebind
+  {
+    using other = pool_allocator<U>;
+  };
+
+public:
+  pool_allocator(memory_counters& counters, slab_pool* p_pool) noexcept
+  : fallback_(counters)
+  , p_pool_(p_pool)
+  {
+  }
+
+  template <typename U>
+  pool_allocator(const pool_allocator<U>& other) noexcept
+  : fallback_(other.fallback())
+  , p_pool_(other.pool())
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    if (p_pool_ && slab_pool::can_allocate(n * sizeof(T), alignof(T)))
+      return static_cast<T*>(p_pool_->allocate(n * sizeof(T)));
+
+    return fallback_.allocate(n);
+  }
+
+  void deallocate(T* p, std::size_t n)
+  {
+    if (p_pool_ && slab_pool::can_allocate(n * sizeof(T), alignof(T)))
+      return p_pool_->deallocate(p, n * sizeof(T));
+
+    fallback_.deallocate(p, n);
+  }
+
+  slab_pool* pool() const
+  {
+    return p_pool_;
+  }
+
+  const memory_allocator<T>& fallback() const
+  {
+    return fallback_;
+  }
+
+  template <typename U> bool operator==(const pool_allocator<U>& other) const
+  {
+    return fallback_ == other.fallback() && p_pool_ == other.pool();
+  }
+
+  template <typename U> bool operator!=(const pool_allocator<U>& other) const
+  {
+    return !(*this == other);
+  }
+
+private:
+  memory_allocator<T> fallback_;
+  slab_pool* p_pool_;
+};
+} // internal
+} // dataflow
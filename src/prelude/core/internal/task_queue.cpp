@@ -0,0 +1,94 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#include "task_queue.h"
+
+#include "config.h"
+
+#include <utility>
+
+namespace dataflow
+{
+namespace internal
+{
+task_queue::task_queue(std::size_t workers_count)
+: workers_()
+, mutex_()
+, cv_()
+, tasks_()
+, stopping_(false)
+{
+  CHECK_PRECONDITION(workers_count > 0);
+
+  workers_.reserve(workers_count);
+
+  for (std::size_t i = 0; i < workers_count; ++i)
+    workers_.emplace_back([this]() { work_(); });
+}
+
+task_queue::~task_queue() noexcept
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    stopping_ = true;
+    tasks_.clear();
+  }
+
+  cv_.notify_all();
+
+  for (auto& worker : workers_)
+    worker.join();
+}
+
+void task_queue::push(task_type task)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    CHECK_PRECONDITION(!stopping_);
+
+    tasks_.push_back(std::move(task));
+  }
+
+  cv_.notify_one();
+}
+
+void task_queue::work_()
+{
+  for (;;)
+  {
+    task_type task;
+
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+
+      cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+
+      if (stopping_)
+        return;
+
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+
+    task();
+  }
+}
+} // internal
+} // dataflow
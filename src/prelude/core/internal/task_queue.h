@@ -0,0 +1,63 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dataflow
+{
+namespace internal
+{
+// Runs submitted tasks on background worker threads in the order of
+// submission. Tasks still queued when the queue is destroyed are dropped,
+// while the running ones are waited for. Tasks must not throw.
+class task_queue final
+{
+public:
+  using task_type = std::function<void()>;
+
+public:
+  explicit task_queue(std::size_t workers_count);
+  ~task_queue() noexcept;
+
+  task_queue(const task_queue&) = delete;
+  task_queue& operator=(const task_queue&) = delete;
+
+  // Thread-safe.
+  void push(task_type task);
+
+private:
+  void work_();
+
+private:
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<task_type> tasks_;
+  bool stopping_;
+};
+} // internal
+} // dataflow
@@ -0,0 +1,269 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#include "thread_pool.h"
+
+#include "config.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace dataflow
+{
+namespace internal
+{
+namespace
+{
+std::uint64_t pack_range(std::size_t begin, std::size_t end)
+{
+  return static_cast<std::uint64_t>(begin) |
+         static_cast<std::uint64_t>(end) << 32;
+}
+
+std::size_t range_begin(std::uint64_t bounds)
+{
+  return static_cast<std::size_t>(bounds & 0xffffffff);
+}
+
+std::size_t range_end(std::uint64_t bounds)
+{
+  return static_cast<std::size_t>(bounds >> 32);
+}
+}
+
+thread_pool::thread_pool(std::size_t workers_count)
+: workers_()
+, run_mutex_()
+, mutex_()
+, start_cv_()
+, done_cv_()
+, generation_(0)
+, active_workers_(0)
+, stopping_(false)
+, p_job_(nullptr)
+, ranges_(workers_count + 1)
+, error_idx_(0)
+, p_error_()
+{
+  workers_.reserve(workers_count);
+
+  for (std::size_t i = 0; i < workers_count; ++i)
+    workers_.emplace_back([this, i]() { work_(i); });
+}
+
+thread_pool::~thread_pool() noexcept
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    stopping_ = true;
+  }
+
+  start_cv_.notify_all();
+
+  for (auto& worker : workers_)
+    worker.join();
+}
+
+thread_pool& thread_pool::shared()
+{
+  // The calling thread takes part in the jobs as well
+  static thread_pool g_pool(
+    std::max<std::size_t>(std::thread::hardware_concurrency(), 2) - 1);
+
+  return g_pool;
+}
+
+std::size_t thread_pool::concurrency() const
+{
+  return workers_.size() + 1;
+}
+
+void thread_pool::run(std::size_t count, const job_type& job)
+{
+  CHECK_ARGUMENT(count <= std::numeric_limits<std::uint32_t>::max());
+
+  if (count == 0)
+    return;
+
+  // Waiting for another thread to release the pool would take longer than
+  // doing the work alone
+  std::unique_lock<std::mutex> run_lock(run_mutex_, std::try_to_lock);
+
+  if (!run_lock || count == 1 || workers_.empty())
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      job(i);
+
+    return;
+  }
+
+  CHECK_PRECONDITION(p_job_ == nullptr);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    p_job_ = &job;
+    error_idx_ = count;
+    p_error_ = nullptr;
+    active_workers_ = workers_.size();
+
+    const auto participants = ranges_.size();
+
+    for (std::size_t p = 0; p < participants; ++p)
+    {
+      ranges_[p].bounds = pack_range(count * p / participants,
+                                     count * (p + 1) / participants);
+    }
+
+    ++generation_;
+  }
+
+  start_cv_.notify_all();
+
+  // The calling thread is the last participant
+  process_(workers_.size());
+
+  std::exception_ptr p_error;
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    done_cv_.wait(lock, [this]() { return active_workers_ == 0; });
+
+    p_job_ = nullptr;
+
+    std::swap(p_error, p_error_);
+  }
+
+  if (p_error)
+    std::rethrow_exception(p_error);
+}
+
+void thread_pool::work_(std::size_t participant)
+{
+  std::size_t generation = 0;
+
+  for (;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+
+      start_cv_.wait(lock, [this, generation]() {
+        return stopping_ || generation_ != generation;
+      });
+
+      if (stopping_)
+        return;
+
+      generation = generation_;
+    }
+
+    process_(participant);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      --active_workers_;
+    }
+
+    done_cv_.notify_one();
+  }
+}
+
+void thread_pool::process_(std::size_t participant)
+{
+  std::size_t i = 0;
+
+  while (pop_(participant, i) || steal_(participant, i))
+  {
+    try
+    {
+      (*p_job_)(i);
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      if (i < error_idx_)
+      {
+        error_idx_ = i;
+        p_error_ = std::current_exception();
+      }
+    }
+  }
+}
+
+bool thread_pool::pop_(std::size_t participant, std::size_t& idx)
+{
+  auto& bounds = ranges_[participant].bounds;
+
+  auto b = bounds.load();
+
+  for (;;)
+  {
+    const auto begin = range_begin(b);
+    const auto end = range_end(b);
+
+    if (begin >= end)
+      return false;
+
+    if (bounds.compare_exchange_weak(b, pack_range(begin + 1, end)))
+    {
+      idx = begin;
+      return true;
+    }
+  }
+}
+
+bool thread_pool::steal_(std::size_t participant, std::size_t& idx)
+{
+  const auto participants = ranges_.size();
+
+  for (std::size_t k = 1; k < participants; ++k)
+  {
+    auto& bounds = ranges_[(participant + k) % participants].bounds;
+
+    auto b = bounds.load();
+
+    for (;;)
+    {
+      const auto begin = range_begin(b);
+      const auto end = range_end(b);
+
+      if (begin >= end)
+        break;
+
+      // The back half, rounded up, so that the last index can be stolen too
+      const auto mid = end - (end - begin + 1) / 2;
+
+      if (bounds.compare_exchange_weak(b, pack_range(begin, mid)))
+      {
+        // Thieves skip the empty range of this participant until this store
+        ranges_[participant].bounds = pack_range(mid + 1, end);
+
+        idx = mid;
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+} // internal
+} // dataflow
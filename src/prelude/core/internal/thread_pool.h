@@ -0,0 +1,98 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dataflow
+{
+namespace internal
+{
+// Runs index-based jobs on a fixed set of worker threads. The calling thread
+// participates in the work. Every participant starts with a contiguous range
+// of indices and takes them from its front. A participant running out of
+// indices steals the back half of the range of another one, so uneven jobs
+// are balanced dynamically.
+class thread_pool final
+{
+public:
+  using job_type = std::function<void(std::size_t)>;
+
+public:
+  explicit thread_pool(std::size_t workers_count);
+  ~thread_pool() noexcept;
+
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  // Process-wide pool with a worker per hardware thread besides the calling
+  // one, created on the first call.
+  static thread_pool& shared();
+
+  std::size_t concurrency() const;
+
+  // Calls `job(i)` for every `i` in `[0, count)` and blocks until all the calls
+  // are finished. The first exception thrown by a job (in the order of
+  // indices) is rethrown in the calling thread. If the pool is running jobs
+  // of another thread, the calls are made in the calling thread rather than
+  // waiting for the pool.
+  void run(std::size_t count, const job_type& job);
+
+private:
+  // Indices left to a participant, packed as `begin | end << 32`. Kept apart
+  // from each other to avoid false sharing.
+  struct range
+  {
+    std::atomic<std::uint64_t> bounds;
+    char padding[64 - sizeof(std::atomic<std::uint64_t>)];
+  };
+
+private:
+  void work_(std::size_t participant);
+  void process_(std::size_t participant);
+
+  bool pop_(std::size_t participant, std::size_t& idx);
+  bool steal_(std::size_t participant, std::size_t& idx);
+
+private:
+  std::vector<std::thread> workers_;
+
+  std::mutex run_mutex_;
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  std::size_t generation_;
+  std::size_t active_workers_;
+  bool stopping_;
+
+  const job_type* p_job_;
+  std::vector<range> ranges_;
+  std::size_t error_idx_;
+  std::exception_ptr p_error_;
+};
+} // internal
+} // dataflow
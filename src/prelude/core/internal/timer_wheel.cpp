@@ -0,0 +1,337 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#include "timer_wheel.h"
+
+#include "config.h"
+
+#include <algorithm>
+
+namespace dataflow
+{
+namespace internal
+{
+constexpr timer_wheel::tick_type timer_wheel::never;
+constexpr std::uint32_t timer_wheel::npos;
+constexpr int timer_wheel::levels;
+constexpr int timer_wheel::slot_bits;
+constexpr std::size_t timer_wheel::slots_per_level;
+constexpr timer_wheel::tick_type timer_wheel::slot_mask;
+
+timer_wheel::timer_wheel()
+: current_(0)
+, size_(0)
+, timers_()
+, free_head_(npos)
+, slots_()
+, expired_()
+{
+  slots_.fill(npos);
+}
+
+timer_wheel::tick_type timer_wheel::now() const
+{
+  return current_;
+}
+
+std::size_t timer_wheel::size() const
+{
+  return size_;
+}
+
+timer_wheel::timer_id
+timer_wheel::start(tick_type expires, tick_type period, callback_type callback)
+{
+  CHECK_PRECONDITION(callback);
+
+  std::uint32_t idx = free_head_;
+
+  if (idx != npos)
+  {
+    free_head_ = timers_[idx].next;
+  }
+  else
+  {
+    CHECK_CONDITION(timers_.size() < npos);
+
+    idx = static_cast<std::uint32_t>(timers_.size());
+    timers_.push_back(timer{callback_type(), 0, 0, 1, npos, npos, npos});
+  }
+
+  auto& t = timers_[idx];
+
+  t.callback = std::move(callback);
+  t.expires = expires > current_ ? expires : current_ + 1;
+  t.period = period;
+
+  link_(idx);
+
+  ++size_;
+
+  return make_id_(idx, t.generation);
+}
+
+bool timer_wheel::stop(timer_id id)
+{
+  const auto p_timer = find_(id);
+
+  if (!p_timer)
+    return false;
+
+  const auto idx = static_cast<std::uint32_t>(p_timer - timers_.data());
+
+  // Expired timers waiting for their callbacks are not linked
+  if (p_timer->slot != npos)
+    unlink_(idx);
+
+  free_(idx);
+
+  return true;
+}
+
+std::size_t timer_wheel::advance(tick_type t)
+{
+  CHECK_PRECONDITION(expired_.empty());
+
+  while (current_ < t)
+  {
+    if (size_ == 0)
+    {
+      current_ = t;
+      break;
+    }
+
+    // Skips the ticks without expirations and cascading
+    current_ = std::min(next_expiration(), t);
+
+    for (int level = 1; level < levels; ++level)
+    {
+      if ((current_ >> (slot_bits * (level - 1)) & slot_mask) != 0)
+        break;
+
+      cascade_(level);
+    }
+
+    const auto slot = static_cast<std::size_t>(current_ & slot_mask);
+
+    while (slots_[slot] != npos)
+    {
+      const auto idx = slots_[slot];
+
+      unlink_(idx);
+
+      expired_.emplace_back(idx, timers_[idx].generation);
+    }
+  }
+
+  std::size_t count = 0;
+
+  for (std::size_t i = 0; i < expired_.size(); ++i)
+  {
+    const auto id = make_id_(expired_[i].first, expired_[i].second);
+
+    // Stopped by one of the previous callbacks
+    if (!find_(id))
+      continue;
+
+    auto& t = timers_[expired_[i].first];
+
+    callback_type callback;
+
+    if (t.period != 0)
+    {
+      callback = t.callback;
+
+      t.expires += t.period;
+
+      if (t.expires <= current_)
+        t.expires = current_ + 1;
+
+      link_(expired_[i].first);
+    }
+    else
+    {
+      callback = std::move(t.callback);
+
+      free_(expired_[i].first);
+    }
+
+    ++count;
+
+    try
+    {
+      callback();
+    }
+    catch (...)
+    {
+      // The timers left without their callbacks called expire next tick
+      for (std::size_t j = i + 1; j < expired_.size(); ++j)
+      {
+        const auto p_timer =
+          find_(make_id_(expired_[j].first, expired_[j].second));
+
+        if (p_timer && p_timer->slot == npos)
+        {
+          p_timer->expires = current_ + 1;
+          link_(expired_[j].first);
+        }
+      }
+
+      expired_.clear();
+      throw;
+    }
+  }
+
+  expired_.clear();
+
+  return count;
+}
+
+timer_wheel::tick_type timer_wheel::next_expiration() const
+{
+  if (size_ == 0)
+    return never;
+
+  tick_type result = never;
+
+  // The earliest non-empty slot of every wheel. For the coarser wheels it is
+  // the moment the slot is cascaded, which is not later than the expiration
+  // of its timers.
+  for (int level = 0; level < levels; ++level)
+  {
+    const auto shift = slot_bits * level;
+    const auto first = (current_ >> shift) + 1;
+
+    for (tick_type k = 0; k < slots_per_level; ++k)
+    {
+      const auto slot = level * slots_per_level +
+                        static_cast<std::size_t>((first + k) & slot_mask);
+
+      if (slots_[slot] != npos)
+      {
+        result = std::min(result, (first + k) << shift);
+        break;
+      }
+    }
+  }
+
+  return result;
+}
+
+timer_wheel::timer_id timer_wheel::make_id_(std::uint32_t idx,
+                                            std::uint32_t generation)
+{
+  return (static_cast<timer_id>(generation) << 32) | idx;
+}
+
+timer_wheel::timer* timer_wheel::find_(timer_id id)
+{
+  const auto idx = static_cast<std::uint32_t>(id & npos);
+  const auto generation = static_cast<std::uint32_t>(id >> 32);
+
+  if (idx >= timers_.size() || timers_[idx].generation != generation ||
+      !timers_[idx].callback)
+  {
+    return nullptr;
+  }
+
+  return &timers_[idx];
+}
+
+void timer_wheel::link_(std::uint32_t idx)
+{
+  auto& t = timers_[idx];
+
+  const auto delta = t.expires - current_;
+
+  int level = 0;
+
+  while (level < levels - 1 &&
+         delta >= (tick_type(1) << (slot_bits * (level + 1))))
+  {
+    ++level;
+  }
+
+  // Timers beyond the coarsest wheel wait in its farthest slot and are
+  // redistributed again when their slot is reached.
+  const auto expires =
+    delta < (tick_type(1) << (slot_bits * levels))
+      ? t.expires
+      : current_ + (tick_type(1) << (slot_bits * levels)) - 1;
+
+  t.slot = static_cast<std::uint32_t>(
+    level * slots_per_level + ((expires >> (slot_bits * level)) & slot_mask));
+  t.prev = npos;
+  t.next = slots_[t.slot];
+
+  if (t.next != npos)
+    timers_[t.next].prev = idx;
+
+  slots_[t.slot] = idx;
+}
+
+void timer_wheel::unlink_(std::uint32_t idx)
+{
+  auto& t = timers_[idx];
+
+  if (t.prev != npos)
+    timers_[t.prev].next = t.next;
+  else
+    slots_[t.slot] = t.next;
+
+  if (t.next != npos)
+    timers_[t.next].prev = t.prev;
+
+  t.slot = npos;
+  t.prev = npos;
+  t.next = npos;
+}
+
+void timer_wheel::free_(std::uint32_t idx)
+{
+  auto& t = timers_[idx];
+
+  t.callback = nullptr;
+  ++t.generation;
+  t.next = free_head_;
+
+  free_head_ = idx;
+
+  --size_;
+}
+
+void timer_wheel::cascade_(int level)
+{
+  const auto slot = static_cast<std::size_t>(
+    level * slots_per_level + ((current_ >> (slot_bits * level)) & slot_mask));
+
+  auto idx = slots_[slot];
+
+  slots_[slot] = npos;
+
+  while (idx != npos)
+  {
+    const auto next = timers_[idx].next;
+
+    link_(idx);
+
+    idx = next;
+  }
+}
+} // internal
+} // dataflow
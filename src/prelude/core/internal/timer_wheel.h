@@ -0,0 +1,113 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace dataflow
+{
+namespace internal
+{
+// Hierarchical timer wheel (Varghese & Lauck). Time is measured in integer
+// ticks. Timers are kept in intrusive lists attached to the slots of four
+// wheels of 256 slots each, the wheel being chosen by the distance to the
+// expiration time. Starting and stopping a timer is O(1). Whenever the
+// current time passes a full turn of a wheel, the timers of the next slot of
+// the coarser wheel are redistributed to the finer ones. Not thread-safe.
+class timer_wheel final
+{
+public:
+  using tick_type = std::uint64_t;
+  using timer_id = std::uint64_t;
+  using callback_type = std::function<void()>;
+
+  static constexpr tick_type never = std::numeric_limits<tick_type>::max();
+
+public:
+  timer_wheel();
+
+  timer_wheel(const timer_wheel&) = delete;
+  timer_wheel& operator=(const timer_wheel&) = delete;
+
+  tick_type now() const;
+
+  std::size_t size() const;
+
+  // Starts a timer expiring at `expires` (but not earlier than the next tick)
+  // and then every `period` ticks if `period` is not `0`. Returns a non-zero
+  // id of the timer.
+  timer_id start(tick_type expires, tick_type period, callback_type callback);
+
+  // Returns `false` if the timer has already expired or been stopped.
+  bool stop(timer_id id);
+
+  // Advances the current time to `t` calling the callbacks of the expired
+  // timers. The callbacks are allowed to start and stop timers. Returns the
+  // number of called callbacks.
+  std::size_t advance(tick_type t);
+
+  // Returns a tick not later than the earliest expiration time, or `never` if
+  // there are no timers.
+  tick_type next_expiration() const;
+
+private:
+  static constexpr std::uint32_t npos =
+    std::numeric_limits<std::uint32_t>::max();
+  static constexpr int levels = 4;
+  static constexpr int slot_bits = 8;
+  static constexpr std::size_t slots_per_level = std::size_t(1) << slot_bits;
+  static constexpr tick_type slot_mask = slots_per_level - 1;
+
+  struct timer
+  {
+    callback_type callback;
+    tick_type expires;
+    tick_type period;
+    std::uint32_t generation;
+    std::uint32_t slot;
+    std::uint32_t prev;
+    std::uint32_t next;
+  };
+
+  static timer_id make_id_(std::uint32_t idx, std::uint32_t generation);
+
+  timer* find_(timer_id id);
+
+  void link_(std::uint32_t idx);
+  void unlink_(std::uint32_t idx);
+  void free_(std::uint32_t idx);
+
+  void cascade_(int level);
+
+private:
+  tick_type current_;
+  std::size_t size_;
+  std::vector<timer> timers_;
+  std::uint32_t free_head_;
+  std::array<std::uint32_t, levels * slots_per_level> slots_;
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> expired_;
+};
+} // internal
+} // dataflow
@@ -0,0 +1,636 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "config.h"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace dataflow
+{
+namespace internal
+{
+/// Ordered list answering order queries in constant time.
+///
+/// Every element carries an integer label increasing along the list, so two
+/// elements are ordered by comparing their labels. When a new element finds
+/// no free label, the smallest aligned range of labels around it that is
+/// sparse enough is relabeled evenly (Bender et al., "Two simplified
+/// algorithms for maintaining order in a list"). This takes amortized
+/// O(log n) time per insertion.
+///
+/// Marked elements are kept in a binary heap ordered by labels, so the first
+/// marked element is found in constant time. Relabeling does not change the
+/// order of the elements, hence it keeps the heap valid.
+///
+/// Alternatively (`dense_marking`), the elements get dense ranks in the list
+/// order and the marks are kept in a bitset indexed by the ranks. Marking is
+/// then constant time and the first marked element is found by scanning the
+/// bitset word by word. Elements inserted after the ranks were assigned have
+/// no rank. Their marks are kept aside until the first marked element is
+/// looked up, which ranks the whole list anew once for all of them. This
+/// makes the mode suitable for lists that rarely change between the markings.
+///
+template <typename T, typename Allocator> class labeled_list final
+{
+private:
+  struct item
+  {
+    T value;
+    // Index in the heap of marked items, or the rank of the item if the
+    // marking is dense
+    std::uint32_t slot;
+    std::uint64_t label;
+    item* p_prev;
+    item* p_next;
+  };
+
+  using item_allocator =
+    typename std::allocator_traits<Allocator>::template rebind_alloc<item>;
+  using item_allocator_traits = std::allocator_traits<item_allocator>;
+  using item_vector = std::vector<
+    item*,
+    typename std::allocator_traits<Allocator>::template rebind_alloc<item*>>;
+  using word_vector =
+    std::vector<std::uint64_t,
+                typename std::allocator_traits<
+                  Allocator>::template rebind_alloc<std::uint64_t>>;
+
+  static constexpr std::uint32_t no_slot = ~std::uint32_t();
+  // The slot of a marked item waiting for its rank
+  static constexpr std::uint32_t unranked_mark = no_slot - 1;
+  static constexpr std::size_t word_bits = 64;
+  static constexpr int max_level = 62;
+  static constexpr std::uint64_t max_label = std::uint64_t(1) << max_level;
+
+public:
+  using value_type = T;
+  using allocator_type = Allocator;
+
+  class const_iterator final
+  {
+    friend class labeled_list;
+
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+  public:
+    const_iterator()
+    : p_item_()
+    {
+    }
+
+    reference operator*() const
+    {
+      return p_item_->value;
+    }
+
+    const_iterator& operator++()
+    {
+      p_item_ = p_item_->p_next;
+      return *this;
+    }
+
+    const_iterator operator++(int)
+    {
+      const auto it = *this;
+      ++*this;
+      return it;
+    }
+
+    const_iterator& operator--()
+    {
+      p_item_ = p_item_->p_prev;
+      return *this;
+    }
+
+    const_iterator operator--(int)
+    {
+      const auto it = *this;
+      --*this;
+      return it;
+    }
+
+    bool operator==(const const_iterator& other) const
+    {
+      return p_item_ == other.p_item_;
+    }
+
+    bool operator!=(const const_iterator& other) const
+    {
+      return p_item_ != other.p_item_;
+    }
+
+  private:
+    explicit const_iterator(item* p_item)
+    : p_item_(p_item)
+    {
+    }
+
+  private:
+    item* p_item_;
+  };
+
+  /// Iterates marked elements in their list order.
+  ///
+  /// Only the first marked element is reachable, which is enough for
+  /// processing marked elements one by one.
+  ///
+  class marked_iterator final
+  {
+    friend class labeled_list;
+
+  public:
+    const T& operator*() const
+    {
+      return *pos_;
+    }
+
+    const_iterator base() const
+    {
+      return pos_;
+    }
+
+    bool operator==(const marked_iterator& other) const
+    {
+      return pos_ == other.pos_;
+    }
+
+    bool operator!=(const marked_iterator& other) const
+    {
+      return pos_ != other.pos_;
+    }
+
+  private:
+    explicit marked_iterator(const_iterator pos)
+    : pos_(pos)
+    {
+    }
+
+  private:
+    const_iterator pos_;
+  };
+
+public:
+  explicit labeled_list(const Allocator& allocator = Allocator(),
+                        bool dense_marking = false)
+  : allocator_(allocator)
+  , p_end_(new_item_(T(), max_label))
+  , size_()
+  , marked_(allocator)
+  , dense_marking_(dense_marking)
+  , words_(allocator)
+  , ranked_(allocator)
+  , first_word_()
+  , unranked_marks_()
+  {
+    p_end_->p_prev = p_end_;
+    p_end_->p_next = p_end_;
+  }
+
+  ~labeled_list() noexcept
+  {
+    for (auto p_item = p_end_->p_next; p_item != p_end_;)
+    {
+      const auto p_next = p_item->p_next;
+      delete_item_(p_item);
+      p_item = p_next;
+    }
+
+    delete_item_(p_end_);
+  }
+
+  labeled_list(const labeled_list&) = delete;
+  labeled_list& operator=(const labeled_list&) = delete;
+
+  const_iterator begin() const
+  {
+    return const_iterator(p_end_->p_next);
+  }
+
+  const_iterator end() const
+  {
+    return const_iterator(p_end_);
+  }
+
+  const T& front() const
+  {
+    CHECK_PRECONDITION(size_ != 0);
+
+    return p_end_->p_next->value;
+  }
+
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+  /// Inserts `value` before `pos`.
+  const_iterator insert(const_iterator pos, const T& value)
+  {
+    const auto p_next = pos.p_item_;
+
+    std::uint64_t label = free_label_(p_next);
+
+    if (label == max_label)
+    {
+      relabel_(p_next->p_prev != p_end_ ? p_next->p_prev : p_next);
+      label = free_label_(p_next);
+
+      CHECK_CONDITION(label != max_label);
+    }
+
+    const auto p_item = new_item_(value, label);
+
+    p_item->p_prev = p_next->p_prev;
+    p_item->p_next = p_next;
+    p_next->p_prev->p_next = p_item;
+    p_next->p_prev = p_item;
+
+    ++size_;
+
+    return const_iterator(p_item);
+  }
+
+  void erase(const_iterator pos)
+  {
+    const auto p_item = pos.p_item_;
+
+    CHECK_PRECONDITION(p_item != p_end_);
+
+    if (dense_marking_)
+      unrank_(p_item);
+    else if (p_item->slot != no_slot)
+      heap_erase_(p_item);
+
+    p_item->p_prev->p_next = p_item->p_next;
+    p_item->p_next->p_prev = p_item->p_prev;
+
+    delete_item_(p_item);
+
+    --size_;
+  }
+
+  /// Checks whether `a` precedes `b`.
+  bool order(const_iterator a, const_iterator b) const
+  {
+    return a.p_item_->label < b.p_item_->label;
+  }
+
+  void mark(const_iterator pos)
+  {
+    const auto p_item = pos.p_item_;
+
+    CHECK_PRECONDITION(p_item != p_end_);
+
+    if (dense_marking_)
+    {
+      if (p_item->slot == no_slot)
+      {
+        p_item->slot = unranked_mark;
+        ++unranked_marks_;
+      }
+
+      if (p_item->slot == unranked_mark)
+        return;
+
+      const auto word = p_item->slot / word_bits;
+
+      words_[word] |= std::uint64_t(1) << (p_item->slot % word_bits);
+
+      if (word < first_word_)
+        first_word_ = word;
+
+      return;
+    }
+
+    if (p_item->slot != no_slot)
+      return;
+
+    marked_.push_back(p_item);
+    p_item->slot = static_cast<std::uint32_t>(marked_.size() - 1);
+    sift_up_(p_item->slot);
+  }
+
+  void unmark(const_iterator pos)
+  {
+    const auto p_item = pos.p_item_;
+
+    if (dense_marking_)
+    {
+      if (p_item->slot == unranked_mark)
+      {
+        p_item->slot = no_slot;
+        --unranked_marks_;
+      }
+      else if (p_item->slot != no_slot)
+      {
+        words_[p_item->slot / word_bits] &=
+          ~(std::uint64_t(1) << (p_item->slot % word_bits));
+      }
+    }
+    else if (p_item->slot != no_slot)
+    {
+      heap_erase_(p_item);
+    }
+  }
+
+  bool marked(const_iterator pos) const
+  {
+    const auto p_item = pos.p_item_;
+
+    if (dense_marking_)
+    {
+      if (p_item->slot == unranked_mark)
+        return true;
+
+      return p_item->slot != no_slot &&
+             (words_[p_item->slot / word_bits] >>
+              (p_item->slot % word_bits)) & 1;
+    }
+
+    return p_item->slot != no_slot;
+  }
+
+  marked_iterator begin_marked() const
+  {
+    if (dense_marking_)
+    {
+      if (unranked_marks_ != 0)
+        rank_();
+
+      while (first_word_ < words_.size() && words_[first_word_] == 0)
+        ++first_word_;
+
+      if (first_word_ == words_.size())
+        return end_marked();
+
+      const auto rank =
+        first_word_ * word_bits + find_first_set_(words_[first_word_]);
+
+      return marked_iterator(const_iterator(ranked_[rank]));
+    }
+
+    return marked_iterator(
+      const_iterator(marked_.empty() ? p_end_ : marked_.front()));
+  }
+
+  marked_iterator end_marked() const
+  {
+    return marked_iterator(end());
+  }
+
+private:
+  item* new_item_(const T& value, std::uint64_t label)
+  {
+    const auto p_item = item_allocator_traits::allocate(allocator_, 1);
+
+    item_allocator_traits::construct(
+      allocator_, p_item, item{value, no_slot, label, nullptr, nullptr});
+
+    return p_item;
+  }
+
+  void delete_item_(item* p_item) noexcept
+  {
+    item_allocator_traits::destroy(allocator_, p_item);
+    item_allocator_traits::deallocate(allocator_, p_item, 1);
+  }
+
+  // Returns a label between the predecessor of `p_next` and `p_next`, or
+  // `max_label` if there is none.
+  std::uint64_t free_label_(const item* p_next) const
+  {
+    const auto p_prev = p_next->p_prev;
+    const std::uint64_t lo = p_prev != p_end_ ? p_prev->label + 1 : 0;
+    const std::uint64_t hi = p_next->label;
+
+    return lo < hi ? lo + (hi - lo) / 2 : max_label;
+  }
+
+  // Maximal number of elements in a range of `2^level` labels after
+  // relabeling. Density allowed in smaller ranges is higher, which makes
+  // relabeling amortized O(log n).
+  static std::uint64_t capacity_(int level)
+  {
+    static const auto capacities = []() {
+      std::array<std::uint64_t, max_level + 1> result;
+
+      for (int i = 0; i <= max_level; ++i)
+      {
+        result[i] = static_cast<std::uint64_t>(std::ldexp(1.0, i) /
+                                               std::pow(1.4, i));
+      }
+
+      return result;
+    }();
+
+    return capacities[level];
+  }
+
+  // Spreads labels around `p_item` so that there is a gap after it.
+  void relabel_(item* p_item)
+  {
+    auto p_first = p_item;
+    auto p_last = p_item;
+    std::uint64_t count = 1;
+
+    for (int level = 1; level <= max_level; ++level)
+    {
+      const std::uint64_t range = std::uint64_t(1) << level;
+      const std::uint64_t lo = p_item->label & ~(range - 1);
+      const std::uint64_t hi = lo + range;
+
+      while (p_first->p_prev != p_end_ && p_first->p_prev->label >= lo)
+      {
+        p_first = p_first->p_prev;
+        ++count;
+      }
+
+      while (p_last->p_next != p_end_ && p_last->p_next->label < hi)
+      {
+        p_last = p_last->p_next;
+        ++count;
+      }
+
+      // One more slot for the element being inserted
+      if (count + 1 <= capacity_(level))
+      {
+        const std::uint64_t step = range / (count + 1);
+
+        std::uint64_t label = lo;
+        for (auto p = p_first; p != p_last->p_next; p = p->p_next)
+        {
+          label += step;
+          p->label = label;
+        }
+
+        return;
+      }
+    }
+
+    CHECK_NOT_REACHABLE();
+  }
+
+  static std::size_t find_first_set_(std::uint64_t word)
+  {
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward64(&idx, word);
+    return idx;
+#else
+    return static_cast<std::size_t>(__builtin_ctzll(word));
+#endif
+  }
+
+  // Assigns the ranks to all the elements keeping their marks
+  void rank_() const
+  {
+    word_vector words((size_ + word_bits - 1) / word_bits,
+                      0,
+                      words_.get_allocator());
+
+    ranked_.resize(size_);
+
+    std::uint32_t rank = 0;
+    for (auto p_item = p_end_->p_next; p_item != p_end_;
+         p_item = p_item->p_next, ++rank)
+    {
+      if (p_item->slot == unranked_mark ||
+          (p_item->slot != no_slot &&
+           (words_[p_item->slot / word_bits] >> (p_item->slot % word_bits)) &
+             1))
+      {
+        words[rank / word_bits] |= std::uint64_t(1) << (rank % word_bits);
+      }
+
+      p_item->slot = rank;
+      ranked_[rank] = p_item;
+    }
+
+    words_.swap(words);
+    first_word_ = 0;
+    unranked_marks_ = 0;
+  }
+
+  void unrank_(item* p_item)
+  {
+    unmark(const_iterator(p_item));
+
+    if (p_item->slot != no_slot)
+      ranked_[p_item->slot] = nullptr;
+  }
+
+  bool heap_less_(std::uint32_t i, std::uint32_t j) const
+  {
+    return marked_[i]->label < marked_[j]->label;
+  }
+
+  void heap_swap_(std::uint32_t i, std::uint32_t j)
+  {
+    std::swap(marked_[i], marked_[j]);
+    marked_[i]->slot = i;
+    marked_[j]->slot = j;
+  }
+
+  void sift_up_(std::uint32_t idx)
+  {
+    while (idx > 0)
+    {
+      const std::uint32_t parent = (idx - 1) / 2;
+
+      if (!heap_less_(idx, parent))
+        break;
+
+      heap_swap_(idx, parent);
+      idx = parent;
+    }
+  }
+
+  void sift_down_(std::uint32_t idx)
+  {
+    const auto size = static_cast<std::uint32_t>(marked_.size());
+
+    for (;;)
+    {
+      const std::uint32_t left = 2 * idx + 1;
+      const std::uint32_t right = left + 1;
+      std::uint32_t min = idx;
+
+      if (left < size && heap_less_(left, min))
+        min = left;
+
+      if (right < size && heap_less_(right, min))
+        min = right;
+
+      if (min == idx)
+        break;
+
+      heap_swap_(idx, min);
+      idx = min;
+    }
+  }
+
+  void heap_erase_(item* p_item)
+  {
+    const auto idx = p_item->slot;
+    const auto last = static_cast<std::uint32_t>(marked_.size() - 1);
+
+    if (idx != last)
+      heap_swap_(idx, last);
+
+    marked_.pop_back();
+    p_item->slot = no_slot;
+
+    if (idx != last)
+    {
+      sift_up_(idx);
+      sift_down_(idx);
+    }
+  }
+
+private:
+  item_allocator allocator_;
+  item* const p_end_;
+  std::size_t size_;
+  item_vector marked_;
+  const bool dense_marking_;
+  // The ranks are assigned lazily, when the marked elements are looked up
+  mutable word_vector words_;
+  mutable item_vector ranked_;
+  mutable std::size_t first_word_;
+  mutable std::size_t unranked_marks_;
+};
+} // internal
+} // dataflow
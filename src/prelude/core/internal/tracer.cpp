@@ -0,0 +1,193 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#include "tracer.h"
+
+#include "config.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+
+namespace dataflow
+{
+namespace internal
+{
+namespace
+{
+const char* category(tracer::event_type type)
+{
+  switch (type)
+  {
+  case tracer::event_type::pump:
+    return "pump";
+  case tracer::event_type::round:
+    return "round";
+  case tracer::event_type::update:
+    return "update";
+  case tracer::event_type::activation:
+    return "activation";
+  case tracer::event_type::deactivation:
+    return "deactivation";
+  }
+
+  CHECK_NOT_REACHABLE();
+
+  return "";
+}
+
+void write_escaped(std::ostream& out, const std::string& s)
+{
+  out << '"';
+
+  for (const auto c : s)
+  {
+    if (c == '"' || c == '\\')
+      out << '\\' << c;
+    else if (static_cast<unsigned char>(c) < 0x20)
+      out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+          << static_cast<int>(c) << std::dec << std::setfill(' ');
+    else
+      out << c;
+  }
+
+  out << '"';
+}
+
+// Trace events use microseconds
+void write_us(std::ostream& out, tracer::clock_type::duration d)
+{
+  const auto ns = std::max<std::int64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(d).count(), 0);
+
+  out << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000
+      << std::setfill(' ');
+}
+
+void write_args(std::ostream& out, const tracer::event& e)
+{
+  switch (e.type)
+  {
+  case tracer::event_type::pump:
+    out << "{\"tick\":" << e.id
+        << ",\"interrupted\":" << (e.value ? "false" : "true") << "}";
+    break;
+  case tracer::event_type::round:
+    out << "{\"tick\":" << e.id << ",\"updated\":" << e.value << "}";
+    break;
+  case tracer::event_type::update:
+    out << "{\"vertex\":" << e.id
+        << ",\"changed\":" << (e.value ? "true" : "false") << "}";
+    break;
+  case tracer::event_type::activation:
+  case tracer::event_type::deactivation:
+    out << "{\"vertex\":" << e.id << "}";
+    break;
+  }
+}
+}
+
+tracer::tracer()
+: mutex_()
+, enabled_(false)
+, events_()
+, origin_(clock_type::now())
+, threads_()
+{
+}
+
+void tracer::start(std::size_t capacity)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  events_.reset(capacity != 0 ? capacity
+                              : std::numeric_limits<std::size_t>::max());
+  origin_ = clock_type::now();
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void tracer::stop()
+{
+  enabled_.store(false, std::memory_order_relaxed);
+}
+
+tracer::clock_type::time_point tracer::now() const
+{
+  return enabled() ? clock_type::now() : clock_type::time_point();
+}
+
+void tracer::record(event_type type,
+                    clock_type::time_point start,
+                    std::string label,
+                    std::size_t id,
+                    std::size_t value)
+{
+  if (!enabled())
+    return;
+
+  const auto finish = clock_type::now();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  events_.push_back(event{type,
+                          start,
+                          finish - start,
+                          std::move(label),
+                          id,
+                          value,
+                          thread_index_(std::this_thread::get_id())});
+}
+
+void tracer::write(std::ostream& out) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  out << "{\"traceEvents\":[";
+
+  for (std::size_t i = 0; i < events_.size(); ++i)
+  {
+    const auto& e = events_[i];
+
+    out << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+    write_escaped(out, e.label);
+    out << ",\"cat\":\"" << category(e.type) << "\",\"ph\":\"X\",\"ts\":";
+    write_us(out, e.start - origin_);
+    out << ",\"dur\":";
+    write_us(out, e.duration);
+    out << ",\"pid\":1,\"tid\":" << e.thread << ",\"args\":";
+    write_args(out, e);
+    out << "}";
+  }
+
+  out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+std::size_t tracer::thread_index_(std::thread::id id)
+{
+  const auto it = std::find(threads_.begin(), threads_.end(), id);
+
+  if (it != threads_.end())
+    return static_cast<std::size_t>(it - threads_.begin());
+
+  threads_.push_back(id);
+
+  return threads_.size() - 1;
+}
+} // internal
+} // dataflow
@@ -0,0 +1,99 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "ring_buffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dataflow
+{
+namespace internal
+{
+// Records the execution of the pumps and writes it as Chrome trace events
+// (see `introspect::start_tracing()`). With a limited capacity only the
+// latest events are kept.
+class tracer final
+{
+public:
+  using clock_type = std::chrono::steady_clock;
+
+  enum class event_type
+  {
+    pump,         // id - tick, value - 1 if the pump finished
+    round,        // id - tick, value - number of updated nodes
+    update,       // id - vertex, value - 1 if the node changed
+    activation,   // id - vertex
+    deactivation, // id - vertex
+  };
+
+  struct event
+  {
+    event_type type;
+    clock_type::time_point start;
+    clock_type::duration duration;
+    std::string label;
+    std::size_t id;
+    std::size_t value;
+    std::size_t thread;
+  };
+
+public:
+  tracer();
+
+  void start(std::size_t capacity);
+  void stop();
+
+  bool enabled() const
+  {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the default time point if the tracing is disabled
+  clock_type::time_point now() const;
+
+  // Can be called concurrently
+  void record(event_type type,
+              clock_type::time_point start,
+              std::string label,
+              std::size_t id,
+              std::size_t value = 0);
+
+  void write(std::ostream& out) const;
+
+private:
+  std::size_t thread_index_(std::thread::id id);
+
+private:
+  mutable std::mutex mutex_;
+  // Read by the pool workers without the lock
+  std::atomic<bool> enabled_;
+  ring_buffer<event> events_;
+  clock_type::time_point origin_;
+  std::vector<std::thread::id> threads_;
+};
+} // internal
+} // dataflow
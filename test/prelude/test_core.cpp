@@ -26,6 +26,13 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
 using namespace dataflow;
 
 namespace dataflow_test
@@ -122,6 +129,120 @@ template <typename T> ref<box<T>> Box(const ref<T>& value)
   return Const(make_box(value));
 }
 
+struct versioned_value
+{
+  using version_type = int;
+
+  int version() const
+  {
+    return stamp;
+  }
+
+  bool operator==(const versioned_value& other) const
+  {
+    ++comparisons_count;
+
+    return value == other.value;
+  }
+
+  bool operator!=(const versioned_value& other) const
+  {
+    return !(*this == other);
+  }
+
+  friend std::ostream& operator<<(std::ostream& out, const versioned_value& v)
+  {
+    return out << v.value << "@" << v.stamp;
+  }
+
+  int value;
+  int stamp;
+
+  static int comparisons_count;
+};
+
+int versioned_value::comparisons_count = 0;
+
+// Has a `version()` member, but does not opt in to be compared by it
+struct release
+{
+  int version() const
+  {
+    return generation;
+  }
+
+  bool operator==(const release& other) const
+  {
+    ++comparisons_count;
+
+    return generation == other.generation && revision == other.revision;
+  }
+
+  bool operator!=(const release& other) const
+  {
+    return !(*this == other);
+  }
+
+  friend std::ostream& operator<<(std::ostream& out, const release& v)
+  {
+    return out << v.generation << "." << v.revision;
+  }
+
+  int generation;
+  int revision;
+
+  static int comparisons_count;
+};
+
+int release::comparisons_count = 0;
+
+struct copy_counted
+{
+  copy_counted(int value = 0)
+  : value(value)
+  {
+  }
+
+  copy_counted(const copy_counted& other)
+  : value(other.value)
+  {
+    ++copies_count;
+  }
+
+  copy_counted(copy_counted&& other) = default;
+
+  copy_counted& operator=(const copy_counted& other)
+  {
+    value = other.value;
+    ++copies_count;
+
+    return *this;
+  }
+
+  copy_counted& operator=(copy_counted&& other) = default;
+
+  bool operator==(const copy_counted& other) const
+  {
+    return value == other.value;
+  }
+
+  bool operator!=(const copy_counted& other) const
+  {
+    return !(*this == other);
+  }
+
+  friend std::ostream& operator<<(std::ostream& out, const copy_counted& v)
+  {
+    return out << v.value;
+  }
+
+  int value;
+
+  static int copies_count;
+};
+
+int copy_counted::copies_count = 0;
+
 BOOST_AUTO_TEST_SUITE(test_core)
 
 BOOST_AUTO_TEST_CASE(test_Box)
@@ -242,6 +363,46 @@ BOOST_AUTO_TEST_CASE(test_Box_LiftSelector_additional_parameters)
   BOOST_CHECK_EQUAL(*f, 3);
 }
 
+BOOST_AUTO_TEST_CASE(test_Box_LiftSelector_duplicate_consumers)
+{
+  EngineTest engine;
+
+  auto a = Var(1);
+  auto c = Var(true);
+  auto d = Var(5);
+
+  const auto add = [](int x, int y) { return x + y; };
+
+  // The edges of the selector are relinked next to the edges sharing a target
+  const auto f = Main(BoxedOrDefault(Box(a), c, d));
+  const auto g = Main(core::Lift("add", a, a, add));
+  const auto h = Main(core::Lift("add", d, d, add));
+
+  BOOST_CHECK_EQUAL(*f, 1);
+
+  c = false;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*f, 5);
+
+  c = true;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*f, 1);
+
+  a = 2;
+  d = 3;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*f, 2);
+  BOOST_CHECK_EQUAL(*g, 4);
+  BOOST_CHECK_EQUAL(*h, 6);
+
+  const auto consumers = introspect::consumers(a);
+
+  BOOST_CHECK_EQUAL(std::distance(consumers.first, consumers.second), 3);
+}
+
 BOOST_AUTO_TEST_CASE(test_CurrentTime)
 {
   EngineTest engine;
@@ -1774,5 +1935,1157 @@ BOOST_AUTO_TEST_CASE(test_unit)
   BOOST_CHECK_EQUAL(io.log_string(), "[t=0] x = ();");
 }
 
+BOOST_AUTO_TEST_CASE(test_Engine_parallel_update)
+{
+  Engine engine{engine_options::parallel_update};
+
+  struct incr_policy
+  {
+    static std::string label()
+    {
+      return "incr";
+    }
+    static int calculate(int v)
+    {
+      return v + 1;
+    }
+  };
+
+  struct add_policy
+  {
+    static std::string label()
+    {
+      return "add";
+    }
+    static int calculate(int a, int b)
+    {
+      return a + b;
+    }
+  };
+
+  auto x = Var<int>(1);
+
+  std::vector<ref<int>> level;
+
+  for (int i = 0; i < 256; ++i)
+    level.push_back(core::Lift<incr_policy>(x));
+
+  while (level.size() > 1)
+  {
+    std::vector<ref<int>> next_level;
+
+    for (std::size_t i = 0; i < level.size(); i += 2)
+      next_level.push_back(core::Lift<add_policy>(level[i], level[i + 1]));
+
+    level.swap(next_level);
+  }
+
+  const auto y = Main(level.front());
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*y, 512);
+
+  x = 9;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*y, 2560);
+  BOOST_CHECK_EQUAL(introspect::num_updated_nodes(), 256 + 255 + 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_parallel_update_several_engines)
+{
+  // Engines of different threads share the pool
+  const auto run = [](int seed) {
+    Engine engine{engine_options::parallel_update};
+
+    auto x = Var<int>(seed);
+
+    std::vector<ref<int>> level;
+
+    for (int i = 0; i < 64; ++i)
+      level.push_back(core::Lift("incr", x, [](int v) { return v + 1; }));
+
+    while (level.size() > 1)
+    {
+      std::vector<ref<int>> next_level;
+
+      for (std::size_t i = 0; i < level.size(); i += 2)
+        next_level.push_back(core::Lift(
+          "add", level[i], level[i + 1], [](int a, int b) { return a + b; }));
+
+      level.swap(next_level);
+    }
+
+    const auto y = Main(level.front());
+
+    int sum = 0;
+
+    for (int i = 0; i < 100; ++i)
+    {
+      x = seed + i;
+      sum += *y - 64 * (seed + i + 1);
+    }
+
+    return sum;
+  };
+
+  auto a = std::async(std::launch::async, run, 1);
+  auto b = std::async(std::launch::async, run, 1000);
+
+  BOOST_CHECK_EQUAL(a.get(), 0);
+  BOOST_CHECK_EQUAL(b.get(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_parallel_update_uneven_diamond)
+{
+  const auto run = [](engine_options options) {
+    Engine engine{options};
+
+    int v_calls = 0;
+
+    auto x = Var<int>(1);
+
+    const auto u = core::Lift("u", x, [](int a) { return a + 1; });
+    const auto w = core::Lift("w", u, [](int a) { return a * 2; });
+    const auto v = Main(core::Lift("v", x, w, [&](int a, int b) {
+      ++v_calls;
+      return a + b;
+    }));
+
+    BOOST_CHECK_EQUAL(*v, 5);
+
+    v_calls = 0;
+
+    x = 2;
+
+    BOOST_CHECK_EQUAL(*v, 8);
+    BOOST_CHECK_EQUAL(v_calls, 1);
+
+    return introspect::num_updated_nodes();
+  };
+
+  BOOST_CHECK_EQUAL(run(engine_options::parallel_update),
+                    run(engine_options::nothing));
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_Batch)
+{
+  EngineTest engine;
+
+  auto x = Var<int>(1);
+  auto y = Var<int>(2);
+
+  int calls_count = 0;
+
+  const auto z = Main(core::Lift("add", x, y, [&](int a, int b) {
+    ++calls_count;
+    return a + b;
+  }));
+
+  BOOST_CHECK_EQUAL(*z, 3);
+  BOOST_CHECK_EQUAL(calls_count, 1);
+
+  {
+    Engine::Batch batch;
+
+    x = 10;
+    y = 20;
+
+    BOOST_CHECK_EQUAL(*z, 3);
+
+    {
+      Engine::Batch nested_batch;
+
+      x = 30;
+    }
+
+    BOOST_CHECK_EQUAL(*z, 3);
+    BOOST_CHECK_EQUAL(calls_count, 1);
+
+    batch.commit();
+  }
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 50);
+  BOOST_CHECK_EQUAL(calls_count, 2);
+
+  {
+    Engine::Batch batch;
+
+    x = 5;
+    x = 30;
+
+    batch.commit();
+
+    BOOST_CHECK_EQUAL(calls_count, 2);
+  }
+
+  {
+    Engine::Batch batch;
+
+    x = 1;
+
+    batch.commit();
+
+    BOOST_CHECK_EQUAL(*z, 21);
+    BOOST_CHECK_EQUAL(calls_count, 3);
+  }
+
+  try
+  {
+    Engine::Batch batch;
+
+    x = 2;
+
+    throw std::runtime_error("batch failed");
+  }
+  catch (const std::runtime_error&)
+  {
+  }
+
+  // The abandoned batch is not pumped, its update is left to the next pump
+  BOOST_CHECK_EQUAL(calls_count, 3);
+
+  y = 3;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 5);
+  BOOST_CHECK_EQUAL(calls_count, 4);
+
+  {
+    Engine::Batch batch;
+
+    x = 4;
+  }
+
+  BOOST_CHECK_EQUAL(calls_count, 4);
+
+  y = 5;
+
+  BOOST_CHECK_EQUAL(*z, 9);
+  BOOST_CHECK_EQUAL(calls_count, 5);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_Batch_commit_throws)
+{
+  EngineTest engine;
+
+  auto x = Var<int>(1);
+
+  const auto y = Main(core::Lift("check", x, [](int v) {
+    if (v < 0)
+      throw std::invalid_argument("negative value");
+
+    return v;
+  }));
+
+  {
+    Engine::Batch batch;
+
+    x = -1;
+
+    BOOST_CHECK_THROW(batch.commit(), std::invalid_argument);
+  }
+
+  x = 2;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*y, 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_pooled_allocation)
+{
+  Engine engine{engine_options::pooled_allocation};
+
+  auto x = Var<int>(1);
+
+  const auto build = [&]() {
+    std::vector<ref<int>> chain(1, x);
+
+    for (int i = 0; i < 1000; ++i)
+      chain.push_back(core::Lift("incr", chain.back(), [](int v) {
+        return v + 1;
+      }));
+
+    return chain.back();
+  };
+
+  {
+    const auto y = Main(build());
+
+    BOOST_CHECK(graph_invariant_holds());
+    BOOST_CHECK_EQUAL(*y, 1001);
+  }
+
+  const auto memory_consumption = introspect::memory_consumption();
+
+  {
+    const auto y = Main(build());
+
+    x = 2;
+
+    BOOST_CHECK(graph_invariant_holds());
+    BOOST_CHECK_EQUAL(*y, 1002);
+  }
+
+  BOOST_CHECK_EQUAL(introspect::memory_consumption(), memory_consumption);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_topological_order_relabeling)
+{
+  Engine engine;
+
+  auto x = Var<int>(0);
+
+  // Every node of the chain is placed right before its consumer, which
+  // exhausts the free labels and forces relabeling many times.
+  std::vector<ref<int>> chain(1, x);
+
+  for (int i = 0; i < 5000; ++i)
+    chain.push_back(core::Lift("incr", chain.back(), [](int v) {
+      return v + 1;
+    }));
+
+  const auto y = Main(chain.back());
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*y, 5000);
+
+  x = 1;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*y, 5001);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_per_thread)
+{
+  const auto run = [](int n, int& result, std::size_t& memory_consumption) {
+    Engine engine;
+
+    auto x = Var<int>(0);
+
+    std::vector<ref<int>> chain(1, x);
+
+    for (int i = 0; i < n; ++i)
+      chain.push_back(core::Lift("incr", chain.back(), [](int v) {
+        return v + 1;
+      }));
+
+    const auto y = Main(chain.back());
+
+    x = 1;
+
+    result = *y;
+    memory_consumption = introspect::memory_consumption();
+  };
+
+  int result_a = 0;
+  int result_b = 0;
+  std::size_t memory_consumption_a = 0;
+  std::size_t memory_consumption_b = 0;
+
+  std::thread thread_a(
+    run, 100, std::ref(result_a), std::ref(memory_consumption_a));
+  std::thread thread_b(
+    run, 1000, std::ref(result_b), std::ref(memory_consumption_b));
+
+  thread_a.join();
+  thread_b.join();
+
+  BOOST_CHECK_EQUAL(result_a, 101);
+  BOOST_CHECK_EQUAL(result_b, 1001);
+  BOOST_CHECK_LT(memory_consumption_a, memory_consumption_b);
+  BOOST_CHECK_EQUAL(introspect::memory_consumption(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_Var_post)
+{
+  EngineTest engine;
+
+  auto x = Var<int>(0);
+  auto y = Var<int>(0);
+
+  int calls_count = 0;
+
+  const auto z = Main(core::Lift("add", x, y, [&](int a, int b) {
+    ++calls_count;
+    return a + b;
+  }));
+
+  const auto produce = [](var<int>& v) {
+    for (int i = 1; i <= 1000; ++i)
+      v.post(i);
+  };
+
+  std::thread producer_x(produce, std::ref(x));
+  std::thread producer_y(produce, std::ref(y));
+
+  producer_x.join();
+  producer_y.join();
+
+  BOOST_CHECK_EQUAL(*z, 0);
+  BOOST_CHECK_EQUAL(calls_count, 1);
+
+  engine.deliver_posted();
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 2000);
+  BOOST_CHECK_EQUAL(calls_count, 2);
+
+  // Posted values are also applied by the next pump
+  x.post(1);
+  y = 2;
+
+  BOOST_CHECK_EQUAL(*z, 3);
+  BOOST_CHECK_EQUAL(calls_count, 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_Var_post_to_destroyed_variable)
+{
+  EngineTest engine;
+
+  {
+    auto x = Var<int>(0);
+
+    std::thread([&x]() { x.post(1); }).join();
+  }
+
+  // The vertex of the destroyed variable can be taken by another node
+  auto y = Var<double>(0.5);
+
+  const auto z =
+    Main(core::Lift("twice", y, [](double v) { return v * 2; }));
+
+  engine.deliver_posted();
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 1.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_Var_post_to_replaced_variable)
+{
+  EngineTest engine;
+
+  {
+    auto a = Var<int>(1);
+
+    a.post(42);
+  }
+
+  // The new variable of the same type takes the vertex of the destroyed one
+  auto b = Var<int>(7);
+
+  const auto c = Main(b);
+
+  engine.deliver_posted();
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*c, 7);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_common_subexpression_elimination)
+{
+  Engine engine{engine_options::common_subexpression_elimination};
+
+  struct policy
+  {
+    static std::string label()
+    {
+      return "plus";
+    }
+    int calculate(int x, int y)
+    {
+      return x + y;
+    }
+  };
+
+  const auto x = Var<int>(1);
+  const auto y = Var<int>(2);
+
+  const auto n = introspect::num_vertices();
+
+  {
+    const auto a = core::Lift<policy>(x, y);
+    const auto b = core::Lift<policy>(x, y);
+
+    BOOST_CHECK_EQUAL(introspect::num_vertices(), n + 1);
+
+    const auto c = core::Lift<policy>(y, x);
+    const auto d =
+      core::Lift("plus", x, y, [](int x, int y) { return x + y; });
+
+    BOOST_CHECK_EQUAL(introspect::num_vertices(), n + 3);
+
+    const auto z = Main(a);
+    const auto w = Main(b);
+
+    x = 3;
+
+    BOOST_CHECK(graph_invariant_holds());
+    BOOST_CHECK_EQUAL(*z, 5);
+    BOOST_CHECK_EQUAL(*w, 5);
+
+    // The active node is found as well
+    const auto e = core::Lift<policy>(x, y);
+
+    BOOST_CHECK_EQUAL(introspect::num_vertices(), n + 5);
+  }
+
+  BOOST_CHECK_EQUAL(introspect::num_vertices(), n);
+
+  const auto a = core::Lift<policy>(x, y);
+  const auto b = core::Lift<policy>(x, y);
+
+  BOOST_CHECK_EQUAL(introspect::num_vertices(), n + 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_constant_folding)
+{
+  Engine engine{engine_options::constant_folding};
+
+  struct policy
+  {
+    static std::string label()
+    {
+      return "plus";
+    }
+    int calculate(int x, int y)
+    {
+      return x + y;
+    }
+  };
+
+  const auto a = core::Lift<policy>(Const(1), Const(2));
+  const auto b = core::Lift<policy>(a, Const(3));
+
+  BOOST_CHECK_EQUAL(introspect::persistent_node(a), true);
+  BOOST_CHECK_EQUAL(introspect::persistent_node(b), true);
+  BOOST_CHECK_EQUAL(introspect::label(b), "const");
+  BOOST_CHECK_EQUAL(introspect::value(b), "6");
+
+  const auto x = Var<int>(4);
+  const auto c = core::Lift<policy>(b, x);
+  const auto d =
+    core::Lift("plus", a, Const(3), [](int x, int y) { return x + y; });
+
+  BOOST_CHECK_EQUAL(introspect::persistent_node(c), false);
+  BOOST_CHECK_EQUAL(introspect::persistent_node(d), false);
+
+  const auto y = Main(c);
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*y, 10);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_versioned_values)
+{
+  Engine engine;
+
+  auto x = Var<versioned_value>(versioned_value{1, 1});
+  const auto y = Main(x);
+
+  const auto comparisons_count = versioned_value::comparisons_count;
+
+  // Same version means no change, whatever the value is
+  x = versioned_value{2, 1};
+
+  BOOST_CHECK_EQUAL((*y).value, 1);
+
+  x = versioned_value{3, 2};
+
+  BOOST_CHECK_EQUAL((*y).value, 3);
+  BOOST_CHECK_EQUAL((*y).stamp, 2);
+
+  BOOST_CHECK_EQUAL(versioned_value::comparisons_count, comparisons_count);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_unversioned_values_with_version_member)
+{
+  Engine engine;
+
+  auto x = Var<release>(release{1, 0});
+  const auto y = Main(x);
+
+  const auto comparisons_count = release::comparisons_count;
+
+  // The values are compared, not the results of `version()`
+  x = release{1, 1};
+
+  BOOST_CHECK_EQUAL((*y).revision, 1);
+  BOOST_CHECK_GT(release::comparisons_count, comparisons_count);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_move_aware_propagation)
+{
+  Engine engine;
+
+  struct policy
+  {
+    static std::string label()
+    {
+      return "next";
+    }
+    copy_counted calculate(const copy_counted& x)
+    {
+      return copy_counted(x.value + 1);
+    }
+  };
+
+  auto x = Var<copy_counted>(1);
+  const auto y = Main(core::Lift<policy>(x));
+
+  BOOST_CHECK_EQUAL((*y).value, 2);
+
+  copy_counted::copies_count = 0;
+
+  x = copy_counted(5);
+
+  BOOST_CHECK_EQUAL((*y).value, 6);
+
+  // The variable keeps its own copy of the value and `Main` copies the value
+  // of its argument. Everything else is moved.
+  BOOST_CHECK_EQUAL(copy_counted::copies_count, 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_retain_values)
+{
+  Engine engine{engine_options::retain_values};
+
+  auto b = Var(true);
+  auto x = Var(1);
+
+  int calls_count = 0;
+
+  const auto y = core::Lift("tenfold", x, [&](int v) {
+    ++calls_count;
+    return v * 10;
+  });
+  const auto z = Main(If(b, y, Const(0)));
+
+  BOOST_CHECK_EQUAL(*z, 10);
+  BOOST_CHECK_EQUAL(calls_count, 1);
+
+  b = false;
+  b = true;
+
+  // Nothing changed while the branch was inactive
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 10);
+  BOOST_CHECK_EQUAL(calls_count, 1);
+
+  b = false;
+  x = 2;
+  b = true;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 20);
+  BOOST_CHECK_EQUAL(calls_count, 2);
+
+  // The variable is changed back before the reactivation
+  b = false;
+  x = 3;
+  x = 2;
+  b = true;
+
+  BOOST_CHECK_EQUAL(*z, 20);
+  BOOST_CHECK_EQUAL(calls_count, 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_retain_values_parallel_update)
+{
+  const auto run = [](engine_options options) {
+    Engine engine{options | engine_options::retain_values};
+
+    auto b = Var(true);
+    auto x = Var(1);
+
+    const auto y = core::Lift("tenfold", x, [](int v) { return v * 10; });
+    const auto z = Main(If(b, y, Const(0)));
+
+    b = false;
+    b = true;
+
+    BOOST_CHECK_EQUAL(*z, 10);
+
+    return introspect::num_updated_nodes();
+  };
+
+  // Reused nodes are not counted as updated in either mode
+  BOOST_CHECK_EQUAL(run(engine_options::parallel_update),
+                    run(engine_options::nothing));
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_branch_retention)
+{
+  Engine engine;
+
+  engine.set_branch_retention(2, 1);
+
+  auto b = Var(true);
+  auto x = Var(1);
+  auto d = Var(0);
+
+  const auto y = core::Lift("tenfold", x, [](int v) { return v * 10; });
+  const auto z =
+    Main(If(b, y, core::Lift("incr", d, [](int v) { return v + 1; })));
+
+  BOOST_CHECK_EQUAL(*z, 10);
+
+  b = false;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 1);
+  BOOST_CHECK_EQUAL(introspect::active_node(y), true);
+
+  x = 2;
+
+  BOOST_CHECK_EQUAL(*z, 1);
+
+  b = true;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 20);
+
+  d = 4;
+  d = 5;
+
+  // The branch expired
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 20);
+  BOOST_CHECK_EQUAL(introspect::active_node(d), false);
+
+  b = false;
+
+  BOOST_CHECK_EQUAL(*z, 6);
+
+  engine.set_branch_retention(0);
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(introspect::active_node(y), false);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_branch_retention_parked_branch)
+{
+  Engine engine;
+
+  engine.set_branch_retention(3, 2);
+
+  auto b = Var(true);
+  auto x = Var(1);
+
+  int s_calls = 0;
+  int y_calls = 0;
+  int w_calls = 0;
+
+  const auto s = core::Lift("shared", x, [&](int v) {
+    ++s_calls;
+    return v + 100;
+  });
+  const auto y = core::Lift("tenfold", s, [&](int v) {
+    ++y_calls;
+    return v * 10;
+  });
+  const auto w = core::Lift("incr", y, [&](int v) {
+    ++w_calls;
+    return v + 1;
+  });
+  const auto z = Main(If(b, w, s));
+
+  BOOST_CHECK_EQUAL(*z, 1011);
+
+  b = false;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 101);
+
+  x = 2;
+
+  // The parked branch is not updated, the node shared with the active one is
+  BOOST_CHECK_EQUAL(*z, 102);
+  BOOST_CHECK_EQUAL(s_calls, 2);
+  BOOST_CHECK_EQUAL(y_calls, 1);
+  BOOST_CHECK_EQUAL(w_calls, 1);
+
+  b = true;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 1021);
+  BOOST_CHECK_EQUAL(y_calls, 2);
+  BOOST_CHECK_EQUAL(w_calls, 2);
+
+  b = false;
+  b = true;
+
+  // Nothing changed while the branch was parked
+  BOOST_CHECK_EQUAL(*z, 1021);
+  BOOST_CHECK_EQUAL(y_calls, 2);
+  BOOST_CHECK_EQUAL(w_calls, 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_freeze)
+{
+  Engine engine;
+
+  auto a = Var(1);
+  auto b = Var(2);
+
+  int calls_count = 0;
+
+  const auto incr = [&](int v) {
+    ++calls_count;
+    return v + 1;
+  };
+
+  const auto shared = core::Lift("shared", b, incr);
+
+  const auto y = Freeze([&]() {
+    return core::Lift("sum",
+                      core::Lift("a+1", a, incr),
+                      core::Lift("b+2", core::Lift("b+1", shared, incr), incr),
+                      [&](int u, int v) {
+                        ++calls_count;
+                        return u + v;
+                      });
+  });
+
+  const auto z = Main(y);
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 7);
+  BOOST_CHECK_EQUAL(calls_count, 5);
+
+  // `a`, `b`, `shared`, `y`, `z` and the time node
+  BOOST_CHECK_EQUAL(introspect::num_active_nodes(), 6);
+
+  calls_count = 0;
+
+  a = 2;
+
+  BOOST_CHECK_EQUAL(*z, 8);
+  BOOST_CHECK_EQUAL(calls_count, 2);
+
+  calls_count = 0;
+
+  b = 3;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 9);
+  BOOST_CHECK_EQUAL(calls_count, 4);
+
+  // A node referenced from outside is not frozen
+  const auto w = Freeze([&]() { return shared; });
+
+  BOOST_CHECK_EQUAL(w.id(), shared.id());
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_dense_scheduling)
+{
+  Engine engine{engine_options::dense_scheduling};
+
+  auto b = Var(true);
+  auto x = Var(1);
+
+  const auto y = core::Lift("incr", x, [](int v) { return v + 1; });
+  const auto z =
+    Main(If(b,
+            core::Lift("sqr", y, [](int v) { return v * v; }),
+            core::Lift("sub", y, x, [](int u, int v) { return u - v; })));
+
+  BOOST_CHECK_EQUAL(*z, 4);
+
+  x = 2;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 9);
+
+  // Activation of the other branch ranks the nodes anew
+  b = false;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 1);
+
+  x = 5;
+
+  BOOST_CHECK_EQUAL(*z, 1);
+  BOOST_CHECK_EQUAL(introspect::num_updated_nodes(), 4);
+
+  b = true;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*z, 36);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_LiftAsync)
+{
+  Engine engine;
+
+  std::promise<void> release;
+  std::atomic<int> calls_count(0);
+
+  struct policy : test_policy_base
+  {
+    static std::string label()
+    {
+      return "async-sqr";
+    }
+
+    // Squaring of 2 waits for the release
+    int calculate(int v) const
+    {
+      if (v == 2)
+        gate.wait();
+
+      ++*p_calls_count;
+
+      return v * v;
+    }
+
+    std::shared_future<void> gate;
+    std::atomic<int>* p_calls_count;
+  };
+
+  policy p;
+  p.gate = release.get_future().share();
+  p.p_calls_count = &calls_count;
+
+  auto x = Var(1);
+
+  const auto y = Main(core::LiftAsync(std::move(p), x));
+
+  BOOST_CHECK_EQUAL(*y, 0);
+
+  using namespace std::chrono;
+
+  const auto deliver_until = [&](int value, milliseconds timeout) {
+    const auto deadline = steady_clock::now() + timeout;
+
+    while (*y != value && steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(milliseconds(1));
+      engine.deliver_posted();
+    }
+  };
+
+  deliver_until(1, seconds(10));
+
+  BOOST_CHECK_EQUAL(*y, 1);
+
+  x = 2;
+  x = 3;
+
+  deliver_until(9, seconds(10));
+
+  BOOST_CHECK_EQUAL(*y, 9);
+
+  release.set_value();
+
+  while (calls_count != 3)
+    std::this_thread::yield();
+
+  // The stale result is discarded
+  deliver_until(4, milliseconds(100));
+
+  BOOST_CHECK_EQUAL(*y, 9);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_LiftAsync_errors)
+{
+  Engine engine;
+
+  std::promise<void> release;
+  std::atomic<int> calls_count(0);
+
+  struct policy : test_policy_base
+  {
+    static std::string label()
+    {
+      return "async-inverse";
+    }
+
+    int calculate(int v) const
+    {
+      if (v == 0)
+        gate.wait();
+
+      ++*p_calls_count;
+
+      if (v == 0 || v == 2)
+        throw std::invalid_argument("division by zero");
+
+      return 12 / v;
+    }
+
+    std::shared_future<void> gate;
+    std::atomic<int>* p_calls_count;
+  };
+
+  policy p;
+  p.gate = release.get_future().share();
+  p.p_calls_count = &calls_count;
+
+  auto x = Var(0);
+
+  const auto y = Main(core::LiftAsync(std::move(p), x));
+
+  x = 3;
+
+  release.set_value();
+
+  while (calls_count != 2)
+    std::this_thread::yield();
+
+  // The error of the stale computation is discarded
+  using namespace std::chrono;
+
+  const auto deadline = steady_clock::now() + seconds(10);
+
+  while (*y != 4 && steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(milliseconds(1));
+    engine.deliver_posted();
+  }
+
+  BOOST_CHECK_EQUAL(*y, 4);
+
+  x = 2;
+
+  while (calls_count != 3)
+    std::this_thread::yield();
+
+  BOOST_CHECK_THROW(engine.deliver_posted(), std::invalid_argument);
+  BOOST_CHECK_EQUAL(*y, 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_pump_budget)
+{
+  Engine engine;
+
+  auto x = Var(0);
+
+  std::vector<val<int>> ys;
+
+  for (int i = 0; i < 100; ++i)
+    ys.push_back(Main(core::Lift("add", x, [i](int v) { return v + i; })));
+
+  const auto updated_count = [&](int value) {
+    return std::count_if(ys.begin(), ys.end(), [&](const val<int>& y) {
+      return *y == value + static_cast<int>(&y - &ys.front());
+    });
+  };
+
+  engine.set_pump_budget(std::chrono::microseconds(1));
+
+  x = 1;
+
+  BOOST_CHECK(!engine.settled());
+  BOOST_CHECK_LT(updated_count(1), 100);
+
+  int resumes_count = 0;
+  while (!engine.resume_pump())
+    ++resumes_count;
+
+  BOOST_CHECK(engine.settled());
+  BOOST_CHECK_GT(resumes_count, 0);
+  BOOST_CHECK_EQUAL(updated_count(1), 100);
+
+  x = 2;
+
+  BOOST_CHECK(!engine.settled());
+
+  // The next change joins the interrupted pump
+  x = 3;
+
+  BOOST_CHECK(!engine.settled());
+
+  engine.set_pump_budget(std::chrono::microseconds::zero());
+
+  BOOST_CHECK(engine.resume_pump());
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(updated_count(3), 100);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_chain_fusion)
+{
+  Engine engine{engine_options::chain_fusion};
+
+  auto x = Var<int>(0);
+
+  std::vector<ref<int>> chain(1, x);
+
+  for (int i = 0; i < 10; ++i)
+  {
+    chain.push_back(
+      core::Lift("incr", chain.back(), [](int v) { return v + 1; }));
+  }
+
+  const auto y = Main(chain.back());
+
+  x = 1;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*y, 11);
+  BOOST_CHECK_EQUAL(introspect::num_updated_nodes(), 13);
+
+  // The second consumer splits the chain
+  const auto z =
+    Main(core::Lift("twice", chain[5], [](int v) { return v * 2; }));
+
+  BOOST_CHECK_EQUAL(*z, 12);
+
+  x = 2;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*y, 12);
+  BOOST_CHECK_EQUAL(*z, 14);
+  BOOST_CHECK_EQUAL(introspect::num_updated_nodes(), 15);
+
+  // So does the introspection
+  BOOST_CHECK_EQUAL(introspect::value(chain[8]), "10");
+
+  x = 3;
+
+  BOOST_CHECK_EQUAL(*y, 13);
+  BOOST_CHECK_EQUAL(introspect::value(chain[8]), "11");
+
+  // Unchanged values stop the propagation
+  const auto w = Main(core::Lift(
+    "mod", core::Lift("sign", x, [](int v) { return v > 0; }), [](bool v) {
+      return !v;
+    }));
+
+  x = 4;
+
+  BOOST_CHECK_EQUAL(*w, false);
+  BOOST_CHECK_EQUAL(*y, 14);
+  BOOST_CHECK_EQUAL(introspect::num_updated_nodes(), 16);
+}
+
+BOOST_AUTO_TEST_CASE(test_Engine_chain_fusion_pump_budget)
+{
+  Engine engine{engine_options::chain_fusion};
+
+  auto x = Var<int>(0);
+
+  std::vector<ref<int>> chain(1, x);
+
+  for (int i = 0; i < 1000; ++i)
+  {
+    chain.push_back(
+      core::Lift("incr", chain.back(), [](int v) { return v + 1; }));
+  }
+
+  const auto y = Main(chain.back());
+
+  engine.set_pump_budget(std::chrono::microseconds(1));
+
+  x = 1;
+
+  while (!engine.resume_pump())
+    ;
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*y, 1001);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 }
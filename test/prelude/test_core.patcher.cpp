@@ -76,6 +76,43 @@ struct patch
   const bool restored;
   const int diff;
 };
+}
+
+namespace dataflow
+{
+// Variable of `data`, which can also be changed with patches
+template <>
+class var<dataflow_test::data> final
+: public core::var_base<dataflow_test::data>
+{
+public:
+  var(core::var_base<dataflow_test::data> base)
+  : core::var_base<dataflow_test::data>(std::move(base))
+  {
+  }
+
+  var(DATAFLOW_VAR_CONST var& other)
+  : core::var_base<dataflow_test::data>(other)
+  {
+  }
+
+  DATAFLOW_VAR_CONST var&
+  operator=(const dataflow_test::data& v) DATAFLOW_VAR_CONST
+  {
+    this->set_value_(v);
+
+    return *this;
+  }
+
+  void add(int diff)
+  {
+    this->set_patch_(dataflow_test::patch{diff});
+  }
+};
+}
+
+namespace dataflow_test
+{
 
 class patcher_test_counters
 {
@@ -678,5 +715,51 @@ BOOST_AUTO_TEST_CASE(test_LiftPatcher_generic_patch)
   BOOST_CHECK_EQUAL(*z, 0);
 }
 
+BOOST_AUTO_TEST_CASE(test_LiftPatcher_patches_in_batch)
+{
+  EngineTest engine;
+
+  patcher_test_counters counters;
+
+  auto x = Var<data>(data{0});
+  auto y = Var<int>(0);
+
+  auto f = Main(TransformData(counters, x, y));
+
+  BOOST_CHECK_EQUAL(*f, data{0});
+
+  x.add(1);
+
+  BOOST_CHECK_EQUAL(*f, data{1});
+  BOOST_CHECK_EQUAL(counters, patcher_test_counters(1, 1));
+
+  // A patch following an assignment is applied to the assigned value
+  {
+    Engine::Batch batch;
+
+    x = data{100};
+    x.add(1);
+
+    batch.commit();
+  }
+
+  BOOST_CHECK(graph_invariant_holds());
+  BOOST_CHECK_EQUAL(*f, data{101});
+  BOOST_CHECK_EQUAL(counters, patcher_test_counters(1, 2, 1));
+
+  // Patches that cannot be composed are replaced with the difference
+  {
+    Engine::Batch batch;
+
+    x.add(2);
+    x.add(3);
+
+    batch.commit();
+  }
+
+  BOOST_CHECK_EQUAL(*f, data{106});
+  BOOST_CHECK_EQUAL(counters, patcher_test_counters(1, 3, 2));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 }
@@ -0,0 +1,134 @@
+
+//  Copyright (c) 2014 - 2021 Maksym V. Bilinets.
+//
+//  This file is part of Dataflow++.
+//
+//  Dataflow++ is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Dataflow++ is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with Dataflow++. If not, see <http://www.gnu.org/licenses/>.
+
+#include <dataflow/engine_loop.h>
+#include <dataflow/introspect.h>
+
+#include "tools/io_fixture.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <thread>
+
+using namespace dataflow;
+
+namespace dataflow_test
+{
+BOOST_AUTO_TEST_SUITE(test_engine_loop)
+
+BOOST_AUTO_TEST_CASE(test_EngineLoop_Timeout)
+{
+  EngineLoop engine;
+
+  io_fixture io;
+
+  io.capture_output();
+
+  const auto y =
+    Main([](dtime t0) { return introspect::Log(Timeout(20, t0), "x"); });
+
+  const auto started = EngineLoop::clock::now();
+
+  engine.start_timer(std::chrono::milliseconds(100), [&]() { engine.stop(); });
+
+  engine.run();
+
+  io.reset_output();
+
+  BOOST_CHECK(EngineLoop::clock::now() - started >=
+              std::chrono::milliseconds(100));
+  BOOST_CHECK_EQUAL(*y, false);
+  BOOST_CHECK_EQUAL(io.log_string(),
+                    "[t=0] x = false;[t=2] x = true;[t=3] x = false;");
+}
+
+BOOST_AUTO_TEST_CASE(test_EngineLoop_timers)
+{
+  EngineLoop engine;
+
+  auto x = Var<int>(0);
+
+  int calls_count = 0;
+
+  const auto y = Main(core::Lift("count", x, [&](int v) {
+    ++calls_count;
+    return v;
+  }));
+
+  const auto deadline =
+    EngineLoop::clock::now() + std::chrono::milliseconds(10);
+
+  for (int i = 0; i < 100; ++i)
+    engine.start_timer_at(deadline, [&]() { x = *x + 1; });
+
+  const auto cancelled = engine.start_timer_at(deadline, [&]() { x = -1; });
+
+  BOOST_CHECK(engine.stop_timer(cancelled));
+  BOOST_CHECK(!engine.stop_timer(cancelled));
+
+  int ticks = 0;
+
+  const auto periodic = engine.start_timer(
+    std::chrono::milliseconds(5),
+    [&]() { ++ticks; },
+    std::chrono::milliseconds(5));
+
+  engine.start_timer_at(EngineLoop::clock::now() +
+                          std::chrono::milliseconds(50),
+                        [&]() { engine.stop(); });
+
+  engine.run();
+
+  // The timers expired together are processed by a single pump
+  BOOST_CHECK_EQUAL(*y, 100);
+  BOOST_CHECK_EQUAL(calls_count, 2);
+
+  BOOST_CHECK_GE(ticks, 1);
+  BOOST_CHECK(engine.stop_timer(periodic));
+}
+
+BOOST_AUTO_TEST_CASE(test_EngineLoop_post)
+{
+  EngineLoop engine;
+
+  auto x = Var<int>(0);
+
+  const auto y = Main(core::Lift("stop", x, [&](int v) {
+    if (v == 1000)
+      engine.stop();
+    return v;
+  }));
+
+  // Stops the test if the posted values are not delivered
+  engine.start_timer(std::chrono::seconds(10), [&]() { engine.stop(); });
+
+  std::thread producer([&]() {
+    for (int i = 1; i <= 1000; ++i)
+      x.post(i);
+  });
+
+  engine.run();
+
+  producer.join();
+
+  BOOST_CHECK_EQUAL(*y, 1000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}
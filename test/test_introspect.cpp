@@ -31,7 +31,10 @@
 #include <boost/graph/topological_sort.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
 #include <iostream>
+#include <sstream>
+#include <thread>
 
 using namespace dataflow;
 
@@ -389,6 +392,171 @@ BOOST_AUTO_TEST_CASE(test_introspect_current_time)
   BOOST_CHECK_EQUAL(introspect::current_time(), 1);
 }
 
+BOOST_AUTO_TEST_CASE(test_introspect_hottest_nodes)
+{
+  Engine engine{engine_options::profiling};
+
+  auto x = Var<int>(1);
+
+  {
+    const auto slow = core::Lift("slow", x, [](int v) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      return v;
+    });
+    const auto fast = core::Lift("fast", x, [](int v) { return -v; });
+
+    auto m = Main(
+      core::Lift("sum", slow, fast, [](int a, int b) { return a + b; }));
+
+    x = 2;
+    x = 3;
+
+    const auto profiles = introspect::hottest_nodes(2);
+
+    BOOST_REQUIRE_EQUAL(profiles.size(), 2);
+    BOOST_CHECK_EQUAL(profiles[0].label, "slow");
+    BOOST_CHECK_EQUAL(profiles[0].updates_count, 3);
+    BOOST_CHECK_EQUAL(profiles[0].activations_count, 1);
+    BOOST_CHECK_EQUAL(profiles[0].deactivations_count, 0);
+    BOOST_CHECK(profiles[0].total_update_time >= std::chrono::milliseconds(6));
+    BOOST_CHECK(profiles[0].max_update_time >= std::chrono::milliseconds(2));
+    BOOST_CHECK(profiles[1].total_update_time <= profiles[0].total_update_time);
+  }
+
+  // Records of the removed nodes are kept
+  const auto profiles = introspect::hottest_nodes(10);
+
+  BOOST_REQUIRE(!profiles.empty());
+  BOOST_CHECK_EQUAL(profiles[0].label, "slow");
+  BOOST_CHECK_EQUAL(profiles[0].deactivations_count, 1);
+
+  introspect::reset_profile();
+
+  for (const auto& p : introspect::hottest_nodes(10))
+  {
+    BOOST_CHECK_EQUAL(p.updates_count, 0);
+    BOOST_CHECK_EQUAL(p.activations_count, 0);
+  }
+
+  std::stringstream ss;
+  introspect::write_profile(ss, 1);
+
+  BOOST_CHECK_NE(ss.str().find("label"), std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(test_introspect_tracing)
+{
+  Engine engine;
+
+  const auto count = [](const std::string& s, const std::string& what) {
+    std::size_t n = 0;
+    for (auto i = s.find(what); i != std::string::npos; i = s.find(what, i + 1))
+      ++n;
+    return n;
+  };
+
+  auto x = Var<int>(1);
+  auto y = Var<bool>(true);
+
+  introspect::start_tracing();
+
+  auto m = Main(If(y, core::Lift("negate", x, [](int v) { return -v; }), x));
+
+  x = 2;
+  y = false;
+
+  introspect::stop_tracing();
+
+  x = 3;
+
+  std::stringstream ss;
+  introspect::write_trace(ss);
+
+  const auto trace = ss.str();
+
+  BOOST_CHECK_EQUAL(trace.find("{\"traceEvents\":["), 0);
+  BOOST_CHECK_EQUAL(count(trace, "\"cat\":\"pump\""), 3);
+  BOOST_CHECK_EQUAL(count(trace, "\"name\":\"negate\",\"cat\":\"update\""), 2);
+  BOOST_CHECK_EQUAL(
+    count(trace, "\"name\":\"negate\",\"cat\":\"activation\""), 1);
+  BOOST_CHECK_EQUAL(
+    count(trace, "\"name\":\"negate\",\"cat\":\"deactivation\""), 1);
+
+  introspect::start_tracing(2);
+
+  x = 4;
+  x = 5;
+
+  ss.str("");
+  introspect::write_trace(ss);
+
+  BOOST_CHECK_EQUAL(count(ss.str(), "\"ph\":\"X\""), 2);
+  BOOST_CHECK_EQUAL(count(ss.str(), "\"cat\":\"pump\""), 1);
+  BOOST_CHECK_NE(ss.str().find("\"tick\":5"), std::string::npos);
+
+  introspect::stop_tracing();
+}
+
+BOOST_AUTO_TEST_CASE(test_introspect_pump_history)
+{
+  Engine engine;
+
+  auto x = Var<int>(1);
+  auto y = Var<bool>(true);
+  const sig s = Signal();
+
+  auto m = Main(If(y, core::Lift("negate", x, [](int v) { return -v; }), x));
+  auto n = Main(s);
+
+  BOOST_CHECK(introspect::pump_history().empty());
+  BOOST_CHECK_EQUAL(introspect::pump_history_percentile(50).rounds_count, 0);
+
+  introspect::set_pump_history_capacity(3);
+
+  x = 2;
+  s();
+
+  const auto active_nodes_count = introspect::num_active_nodes();
+
+  y = false;
+
+  const auto deactivated_nodes_count =
+    active_nodes_count - introspect::num_active_nodes();
+
+  x = 3;
+
+  const auto history = introspect::pump_history();
+
+  BOOST_REQUIRE_EQUAL(history.size(), 3);
+
+  BOOST_CHECK_EQUAL(history[0].rounds_count, 2);
+  // Time, signal and main nodes change in both rounds
+  BOOST_CHECK_EQUAL(history[0].changed_nodes_count, 6);
+  BOOST_CHECK_EQUAL(history[1].tick, history[0].tick + 1);
+  BOOST_CHECK_EQUAL(history[1].rounds_count, 1);
+  BOOST_CHECK_EQUAL(history[1].deactivations_count -
+                      history[1].activations_count,
+                    deactivated_nodes_count);
+  BOOST_CHECK_EQUAL(history[2].tick, history[1].tick + 1);
+  BOOST_CHECK_EQUAL(history[2].activations_count, 0);
+  BOOST_CHECK_EQUAL(history[2].deactivations_count, 0);
+  BOOST_CHECK_EQUAL(history[2].updated_nodes_count, 4);
+
+  const auto max = introspect::pump_history_percentile(100);
+
+  BOOST_CHECK_EQUAL(max.tick, history[2].tick);
+  BOOST_CHECK_EQUAL(max.rounds_count, 2);
+  BOOST_CHECK_EQUAL(max.deactivations_count, history[1].deactivations_count);
+  BOOST_CHECK_EQUAL(introspect::pump_history_percentile(0).rounds_count, 1);
+  BOOST_CHECK_EQUAL(introspect::pump_history_percentile(50).rounds_count, 1);
+
+  introspect::set_pump_history_capacity(0);
+
+  x = 4;
+
+  BOOST_CHECK(introspect::pump_history().empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // dataflow_test
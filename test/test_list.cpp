@@ -1013,6 +1013,54 @@ BOOST_AUTO_TEST_CASE(test_listC_Var_Map)
   BOOST_CHECK_EQUAL(core::to_string(*f), "list(33 34 35 55 36 37 38)");
 }
 
+BOOST_AUTO_TEST_CASE(test_listC_Var_Map_Batch)
+{
+  Engine engine;
+
+  auto xs = Var<listC<int>>(0, 1, 2, 3);
+
+  int calls_count = 0;
+
+  const auto zs = Map(xs, [&](int x) {
+    ++calls_count;
+    return x * 10;
+  });
+
+  auto f = Main(zs);
+
+  BOOST_CHECK_EQUAL(calls_count, 4);
+
+  BOOST_CHECK_EQUAL(core::to_string(*f), "list(0 10 20 30)");
+
+  {
+    Engine::Batch batch;
+
+    xs.insert(1, 5);
+    xs.insert(0, 7);
+    xs.erase(3);
+
+    BOOST_CHECK_EQUAL(core::to_string(*f), "list(0 10 20 30)");
+
+    batch.commit();
+  }
+
+  BOOST_CHECK_EQUAL(calls_count, 6);
+
+  BOOST_CHECK_EQUAL(core::to_string(*f), "list(70 0 50 20 30)");
+
+  // A patch following an assignment is applied to the assigned value
+  {
+    Engine::Batch batch;
+
+    xs = make_listC(1, 2);
+    xs.insert(0, 9);
+
+    batch.commit();
+  }
+
+  BOOST_CHECK_EQUAL(core::to_string(*f), "list(90 10 20)");
+}
+
 BOOST_AUTO_TEST_CASE(test_ListC_Map)
 {
   Engine engine;
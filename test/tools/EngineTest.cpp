@@ -34,6 +34,30 @@ dataflow::engine_options get_options()
     {
       return dataflow::engine_options::nothing;
     }
+
+    if (std::string(test_suit.argv[1]) == "--parallel-update")
+    {
+      return dataflow::engine_options::fully_optimized |
+             dataflow::engine_options::parallel_update;
+    }
+
+    if (std::string(test_suit.argv[1]) == "--pooled-allocation")
+    {
+      return dataflow::engine_options::fully_optimized |
+             dataflow::engine_options::pooled_allocation;
+    }
+
+    if (std::string(test_suit.argv[1]) == "--dense-scheduling")
+    {
+      return dataflow::engine_options::fully_optimized |
+             dataflow::engine_options::dense_scheduling;
+    }
+
+    if (std::string(test_suit.argv[1]) == "--chain-fusion")
+    {
+      return dataflow::engine_options::fully_optimized |
+             dataflow::engine_options::chain_fusion;
+    }
   }
 
   return dataflow::engine_options::fully_optimized;